@@ -0,0 +1,186 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+
+#include "KiwiArena.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      PAGES                                       //
+    // ================================================================================ //
+    
+    // The blocks of the arenas are aligned on pages and their pages refer to their memory in a radix tree of the addresses, so the memory is freed without a header and a page that isn't in the tree has been allocated from the heap
+    static const size_t alignment   = 16ul;
+    static const size_t page_bits   = 12ul;
+    static const size_t page_size   = size_t(1ul) << page_bits;
+    static const size_t level_bits  = 13ul;
+    static const size_t level_size  = size_t(1ul) << level_bits;
+    static const size_t levels      = 4ul;
+    
+    static atomic<void*> pages[level_size];
+    
+    //! Retrieves the entry of a page in the tree, the nodes are created if needed otherwise nullptr is returned if a node doesn't exist.
+    static atomic<void*>* findPage(void const* ptr, const bool create)
+    {
+        const uint64_t page = uint64_t(uintptr_t(ptr)) >> page_bits;
+        atomic<void*>* entries = pages;
+        for(size_t level = levels - 1ul; level; level--)
+        {
+            atomic<void*>& entry = entries[(page >> (level * level_bits)) & (level_size - 1ul)];
+            void* node = entry.load(memory_order_acquire);
+            if(!node)
+            {
+                if(!create)
+                {
+                    return nullptr;
+                }
+                
+                // The nodes are never freed, another thread can create the same node first
+                atomic<void*>* created = new atomic<void*>[level_size]();
+                if(entry.compare_exchange_strong(node, created, memory_order_acq_rel, memory_order_acquire))
+                {
+                    node = created;
+                }
+                else
+                {
+                    delete [] created;
+                }
+            }
+            entries = static_cast<atomic<void*>*>(node);
+        }
+        return entries + (page & (level_size - 1ul));
+    }
+    
+    // ================================================================================ //
+    //                                      ARENA                                       //
+    // ================================================================================ //
+    
+    class Arena::Memory
+    {
+    private:
+        atomic<ulong>                   m_refs;
+        vector<pair<char*, size_t>>     m_blocks;
+        char*                           m_ptr;
+        char*                           m_end;
+        const size_t                    m_block;
+        size_t                          m_size;
+        
+    public:
+        Memory(const size_t block) noexcept : m_refs(1ul), m_ptr(nullptr), m_end(nullptr), m_block(max(block, size_t(256ul))), m_size(0ul) {}
+        
+        ~Memory() noexcept
+        {
+            for(auto const& block : m_blocks)
+            {
+                for(size_t offset = 0ul; offset < block.second; offset += page_size)
+                {
+                    findPage(block.first + offset, false)->store(nullptr, memory_order_release);
+                }
+                ::operator delete(block.first, align_val_t(page_size));
+            }
+        }
+        
+        //! Allocates memory, the memory retains the arena.
+        void* allocate(size_t size)
+        {
+            size = (max(size, size_t(1ul)) + alignment - 1ul) & ~(alignment - 1ul);
+            if(size_t(m_end - m_ptr) < size)
+            {
+                const size_t block = (max(m_block, size) + page_size - 1ul) & ~(page_size - 1ul);
+                char* ptr = static_cast<char*>(::operator new(block, align_val_t(page_size)));
+                m_blocks.reserve(m_blocks.size() + 1ul);
+                for(size_t offset = 0ul; offset < block; offset += page_size)
+                {
+                    findPage(ptr + offset, true)->store(this, memory_order_release);
+                }
+                m_blocks.emplace_back(ptr, block);
+                m_ptr = ptr;
+                m_end = ptr + block;
+            }
+            void* ptr = m_ptr;
+            m_ptr  += size;
+            m_size += size;
+            m_refs.fetch_add(1ul, memory_order_relaxed);
+            return ptr;
+        }
+        
+        //! Releases the memory when it isn't used anymore.
+        inline void release() noexcept
+        {
+            if(m_refs.fetch_sub(1ul, memory_order_acq_rel) == 1ul)
+            {
+                delete this;
+            }
+        }
+        
+        inline size_t size() const noexcept {return m_size;}
+        
+        inline size_t blocks() const noexcept {return m_blocks.size();}
+    };
+    
+    thread_local Arena* Arena::m_current = nullptr;
+    
+    Arena::Arena(const size_t size) noexcept : m_memory(new Memory(size))
+    {
+        ;
+    }
+    
+    Arena::~Arena() noexcept
+    {
+        m_memory->release();
+    }
+    
+    size_t Arena::getSize() const noexcept
+    {
+        return m_memory->size();
+    }
+    
+    size_t Arena::getNumberOfBlocks() const noexcept
+    {
+        return m_memory->blocks();
+    }
+    
+    void* Arena::allocate(const size_t size)
+    {
+        return m_current ? m_current->m_memory->allocate(size) : ::operator new(size);
+    }
+    
+    void Arena::deallocate(void* ptr) noexcept
+    {
+        if(ptr)
+        {
+            atomic<void*>* page = findPage(ptr, false);
+            Memory* memory = page ? static_cast<Memory*>(page->load(memory_order_acquire)) : nullptr;
+            if(memory)
+            {
+                memory->release();
+            }
+            else
+            {
+                ::operator delete(ptr);
+            }
+        }
+    }
+}
+
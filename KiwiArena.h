@@ -0,0 +1,133 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_ARENA__
+#define __DEF_KIWI_ARENA__
+
+#include "KiwiTools.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      ARENA                                       //
+    // ================================================================================ //
+    
+    //! The arena allocates the memory of the atoms by blocks.
+    /** The arena allocates the memory by bumping a pointer in large blocks, the memory isn't freed piece by piece but all at once when the arena and all the memory allocated from it aren't used anymore. When a scope of an arena is active in a thread, the payloads of the atoms, the memory of the vectors and of the dicos created in this thread are allocated from the arena, so a tree of atoms that is parsed or built at once only allocates a few blocks. The memory allocated from an arena keeps it alive, so the atoms can outlive the arena object. The blocks are aligned on pages and their pages are registered, so the memory is freed without a header whether it has been allocated from an arena or from the heap. An arena must be used by one thread at a time.
+     @see Arena::Scope
+     */
+    class Arena
+    {
+    private:
+        class Memory;
+        
+        Memory*                     m_memory;
+        static thread_local Arena*  m_current;
+        
+    public:
+        
+        //! Constructor.
+        /** Creates an arena.
+         @param size The size of the blocks, rounded up to a multiple of 4096 bytes.
+         */
+        Arena(const size_t size = 65536ul) noexcept;
+        
+        //! Destructor.
+        /** The memory is freed when the memory allocated from the arena isn't used anymore.
+         */
+        ~Arena() noexcept;
+        
+        Arena(Arena const&) = delete;
+        Arena& operator=(Arena const&) = delete;
+        
+        //! Retrieve the size of the memory allocated from the arena.
+        /** The function retrieves the number of bytes allocated from the arena.
+         @return The number of bytes.
+         */
+        size_t getSize() const noexcept;
+        
+        //! Retrieve the number of blocks of the arena.
+        /** The function retrieves the number of blocks allocated by the arena.
+         @return The number of blocks.
+         */
+        size_t getNumberOfBlocks() const noexcept;
+        
+        //! Retrieve the arena of the current thread.
+        /** The function retrieves the arena of the innermost scope active in the current thread.
+         @return The arena or nullptr if no scope is active.
+         */
+        static inline Arena* getCurrent() noexcept {return m_current;}
+        
+        //! Allocates memory.
+        /** The function allocates the memory from the arena of the current thread or from the heap if no scope is active. The memory must be freed with deallocate.
+         @param size The number of bytes.
+         @return The memory aligned for any type.
+         */
+        static void* allocate(const size_t size);
+        
+        //! Frees memory.
+        /** The function frees the memory allocated with allocate from an arena or from the heap.
+         @param ptr The memory.
+         */
+        static void deallocate(void* ptr) noexcept;
+        
+        //! The scope of an arena.
+        /** The scope makes an arena the arena of the current thread until it is destroyed, the scopes can be nested.
+         */
+        class Scope
+        {
+        private:
+            Arena* const m_previous;
+        public:
+            inline Scope(Arena& arena) noexcept : m_previous(m_current) {m_current = &arena;}
+            inline ~Scope() noexcept {m_current = m_previous;}
+            Scope(Scope const&) = delete;
+            Scope& operator=(Scope const&) = delete;
+        };
+    };
+    
+    // ================================================================================ //
+    //                                  ARENA ALLOCATOR                                 //
+    // ================================================================================ //
+    
+    //! The allocator of the standard containers that allocates from the arena of the current thread.
+    /** The allocator allocates from the arena of the current thread or from the heap.
+     @see Arena
+     */
+    template <class T> class ArenaAllocator
+    {
+    public:
+        typedef T value_type;
+        
+        constexpr ArenaAllocator() noexcept {}
+        template <class U> constexpr ArenaAllocator(ArenaAllocator<U> const&) noexcept {}
+        
+        inline T* allocate(const size_t n) {return static_cast<T*>(Arena::allocate(n * sizeof(T)));}
+        inline void deallocate(T* ptr, const size_t) noexcept {Arena::deallocate(ptr);}
+        
+        template <class U> constexpr bool operator==(ArenaAllocator<U> const&) const noexcept {return true;}
+        template <class U> constexpr bool operator!=(ArenaAllocator<U> const&) const noexcept {return false;}
+    };
+}
+
+#endif
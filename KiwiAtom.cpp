@@ -22,6 +22,7 @@
 */
 
 #include "KiwiAtom.h"
+#include "KiwiJson.h"
 
 namespace Kiwi
 {    
@@ -29,255 +30,606 @@ namespace Kiwi
     //                                      ATOM                                        //
     // ================================================================================ //
     
-    Atom::Atom(Atom::Atom const& other) noexcept
+    void Atom::copy(Atom const& other) noexcept
     {
-        if(other.isBool())
+        switch(other.m_type)
         {
-            m_quark = new QuarkBool((bool)other);
+            case BOOLEAN: m_bool = other.m_bool; break;
+            case LONG:    m_long = other.m_long; break;
+            case DOUBLE:  m_double = other.m_double; break;
+            case TAG:     new(&m_tag) sTag(other.m_tag); break;
+            case VECTOR:  m_vector = other.m_vector->retain(); break;
+            case DICO:    m_dico = other.m_dico->retain(); break;
+            case DOUBLES: m_doubles = other.m_doubles->retain(); break;
+            case FLOATS:  m_floats = other.m_floats->retain(); break;
+            case TUPLE:   memcpy(m_tuple, other.m_tuple, sizeof(m_tuple)); m_arity = other.m_arity; break;
+            default:      break;
         }
-        else if(other.isLong())
+        m_type = other.m_type;
+    }
+    
+    bool Atom::operator==(char const* tag) const noexcept
+    {
+        return isTag() && m_tag->getName() == tag;
+    }
+    
+    bool Atom::operator==(string const& tag) const noexcept
+    {
+        return isTag() && m_tag->getName() == tag;
+    }
+    
+    bool Atom::operator==(sTag tag) const noexcept
+    {
+        return isTag() && m_tag == tag;
+    }
+    
+    Atom::operator Tuple() const noexcept
+    {
+        // The containers of more than four numbers are rejected rather than truncated
+        Tuple tuple;
+        if(m_type == TUPLE)
+        {
+            for(ulong i = 0; i < m_arity; i++)
+            {
+                tuple.push_back(m_tuple[i]);
+            }
+        }
+        else if(m_type == VECTOR && m_vector->value.size() <= Tuple::capacity)
         {
-            m_quark = new QuarkLong((long)other);
+            for(auto const& atom : m_vector->value)
+            {
+                tuple.push_back(atom.getDouble());
+            }
         }
-        else if(other.isDouble())
+        else if(m_type == DOUBLES && m_doubles->value.size() <= Tuple::capacity)
         {
-            m_quark = new QuarkDouble((double)other);
+            for(double value : m_doubles->value)
+            {
+                tuple.push_back(value);
+            }
         }
-        else if(other.isTag())
+        else if(m_type == FLOATS && m_floats->value.size() <= Tuple::capacity)
         {
-            m_quark = new QuarkTag((sTag)other);
+            for(float value : m_floats->value)
+            {
+                tuple.push_back(value);
+            }
         }
-        else if(other.isVector())
+        return tuple;
+    }
+    
+    Vector Atom::toVector() const noexcept
+    {
+        if(m_type == TUPLE)
         {
-            m_quark = new QuarkVector((Vector const&)other);
+            return Vector(m_tuple, m_tuple + m_arity);
         }
-        else if(other.isDico())
+        else if(m_type == DOUBLES)
         {
-            m_quark = new QuarkDico((Dico const&)other);
+            return Vector(m_doubles->value.begin(), m_doubles->value.end());
         }
-        else
+        else if(m_type == FLOATS)
         {
-            m_quark = new Quark();
+            return Vector(m_floats->value.begin(), m_floats->value.end());
         }
+        return getVector();
     }
-   
     
-    Atom& Atom::operator=(Atom const& other) noexcept
+    Doubles Atom::toDoubles() const noexcept
     {
-        delete m_quark;
-        if(other.isBool())
+        if(m_type == VECTOR)
         {
-            m_quark = new QuarkBool((bool)other);
+            Doubles values(m_vector->value.size());
+            for(Vector::size_type i = 0; i < values.size(); i++)
+            {
+                values[i] = m_vector->value[i].getDouble();
+            }
+            return values;
         }
-        else if(other.isLong())
+        else if(m_type == FLOATS)
         {
-            m_quark = new QuarkLong((long)other);
+            return Doubles(m_floats->value.begin(), m_floats->value.end());
         }
-        else if(other.isDouble())
+        else if(m_type == TUPLE)
         {
-            m_quark = new QuarkDouble((double)other);
+            return Doubles(m_tuple, m_tuple + m_arity);
         }
-        else if(other.isTag())
+        return getDoubles();
+    }
+    
+    Floats Atom::toFloats() const noexcept
+    {
+        if(m_type == VECTOR)
         {
-            m_quark = new QuarkTag((sTag)other);
+            Floats values(m_vector->value.size());
+            for(Vector::size_type i = 0; i < values.size(); i++)
+            {
+                values[i] = float(m_vector->value[i].getDouble());
+            }
+            return values;
         }
-        else if(other.isVector())
+        else if(m_type == DOUBLES)
         {
-            m_quark = new QuarkVector((Vector const&)other);
+            return Floats(m_doubles->value.begin(), m_doubles->value.end());
         }
-        else if(other.isDico())
+        else if(m_type == TUPLE)
         {
-            m_quark = new QuarkDico((Dico const&)other);
+            return Floats(m_tuple, m_tuple + m_arity);
         }
-        else
+        return getFloats();
+    }
+    
+    //! Mixes the bits of a hash.
+    static inline ulong mix(ulong hash) noexcept
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdul;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ul;
+        hash ^= hash >> 33;
+        return hash;
+    }
+    
+    //! Combines a hash with another.
+    static inline ulong combine(const ulong seed, const ulong hash) noexcept
+    {
+        return mix(seed ^ (hash + 0x9e3779b97f4a7c15ul + (seed << 6) + (seed >> 2)));
+    }
+    
+    //! Retrieves the hash of a number, the integral doubles have the hash of the longs.
+    static inline ulong hashNumber(const double value) noexcept
+    {
+        if(value >= -9223372036854775808. && value < 9223372036854775808. && double(long(value)) == value)
         {
-            m_quark = new Quark();
+            return mix(ulong(long(value)));
         }
-        return *this;
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return mix(bits);
     }
     
-    ostream& Atom::toJson(ostream &output, const Atom &atom, ulong& indent)
+    //! Retrieves the hash of the values of a container.
+    static ulong hashValues(Vector const& atoms) noexcept
     {
-        if(atom.isBool())
+        ulong hash = combine(Atom::VECTOR, atoms.size());
+        for(auto const& atom : atoms)
         {
-            output << (bool)atom;
+            hash = combine(hash, atom.getHash());
         }
-        else if(atom.isLong())
+        return hash;
+    }
+    
+    static ulong hashValues(Dico const& atoms) noexcept
+    {
+        // The hashes of the entries are added so the order doesn't matter
+        ulong sum = 0ul;
+        for(auto const& entry : atoms)
         {
-            output << (long)atom;
+            sum += combine(entry.first->getHash(), entry.second.getHash());
         }
-        else if(atom.isDouble())
+        return combine(combine(Atom::DICO, atoms.size()), sum);
+    }
+    
+    template <class T> static ulong hashValues(vector<T> const& values) noexcept
+    {
+        ulong hash = combine(is_same<T, float>::value ? Atom::FLOATS : Atom::DOUBLES, values.size());
+        for(auto value : values)
         {
-            output << (double)atom;
+            hash = combine(hash, hashNumber(double(value)));
         }
-        else if(atom.isTag())
+        return hash;
+    }
+    
+    template <class T> ulong Atom::cachedHash(Shared<T> const& payload) noexcept
+    {
+        ulong hash = payload.hash.load(memory_order_relaxed);
+        if(!hash)
         {
-            output << jsonEscape(((sTag)atom)->getName());
+            // Zero is kept for the payloads whose hash hasn't been computed
+            hash = hashValues(payload.value);
+            hash = hash ? hash : 1ul;
+            payload.hash.store(hash, memory_order_relaxed);
         }
-        else if(atom.isVector())
+        return hash;
+    }
+    
+    ulong Atom::getHash() const noexcept
+    {
+        switch(m_type)
         {
-            Vector const& vec = atom;
-            output << '[';
-            for(Vector::size_type i = 0; i < vec.size();)
+            case BOOLEAN: return mix(ulong(m_bool));
+            case LONG:    return mix(ulong(m_long));
+            case DOUBLE:  return hashNumber(m_double);
+            case TAG:     return combine(TAG, m_tag->getHash());
+            case VECTOR:  return cachedHash(*m_vector);
+            case DICO:    return cachedHash(*m_dico);
+            case DOUBLES: return cachedHash(*m_doubles);
+            case FLOATS:  return cachedHash(*m_floats);
+            case TUPLE:
             {
-                toJson(output, vec[i], indent);
-                if(++i != vec.size())
+                ulong hash = combine(TUPLE, m_arity);
+                for(unsigned char i = 0; i < m_arity; i++)
                 {
-                    output << ", ";
+                    hash = combine(hash, hashNumber(double(m_tuple[i])));
                 }
+                return hash;
             }
-            output << ']';
+            default:      return 0ul;
+        }
+    }
+    
+    ulong Atom::hash(Vector const& atoms) noexcept
+    {
+        const ulong hash = hashValues(atoms);
+        return hash ? hash : 1ul;
+    }
+    
+    bool Atom::identical(Atom const& lhs, Atom const& rhs) noexcept
+    {
+        if(lhs.m_type != rhs.m_type)
+        {
+            return false;
         }
-        else if(atom.isDico())
+        switch(lhs.m_type)
         {
-            Dico const& dico = atom;
-            output << '{' << endl;
-            ++indent;
-            for(auto it = dico.begin(); it != dico.end();)
+            case BOOLEAN: return lhs.m_bool == rhs.m_bool;
+            case LONG:    return lhs.m_long == rhs.m_long;
+            case DOUBLE:  return lhs.m_double == rhs.m_double;
+            case TAG:     return lhs.m_tag == rhs.m_tag;
+            case VECTOR:
+            {
+                Vector const& lvalues = lhs.m_vector->value;
+                Vector const& rvalues = rhs.m_vector->value;
+                if(lhs.m_vector == rhs.m_vector)
+                {
+                    return true;
+                }
+                return lvalues.size() == rvalues.size() && equal(lvalues.begin(), lvalues.end(), rvalues.begin(), identical);
+            }
+            case DICO:
             {
-                for(ulong i = 0; i < indent; i++)
+                Dico const& lvalues = lhs.m_dico->value;
+                Dico const& rvalues = rhs.m_dico->value;
+                if(lhs.m_dico == rhs.m_dico)
                 {
-                    output << '\t';
+                    return true;
                 }
-                output << jsonEscape(it->first->getName()) << " : ";
-                toJson(output, it->second, indent);
-                if(++it != dico.end())
+                if(lvalues.size() != rvalues.size())
                 {
-                    output << ',' << endl;
+                    return false;
                 }
-                else
+                for(auto const& entry : lvalues)
                 {
-                    output << endl;
+                    auto it = rvalues.find(entry.first);
+                    if(it == rvalues.end() || !identical(entry.second, it->second))
+                    {
+                        return false;
+                    }
                 }
+                return true;
+            }
+            case DOUBLES: return lhs.m_doubles == rhs.m_doubles || lhs.m_doubles->value == rhs.m_doubles->value;
+            case FLOATS:  return lhs.m_floats == rhs.m_floats || lhs.m_floats->value == rhs.m_floats->value;
+            case TUPLE:   return lhs.m_arity == rhs.m_arity && equal(lhs.m_tuple, lhs.m_tuple + lhs.m_arity, rhs.m_tuple);
+            default:      return true;
+        }
+    }
+    
+    ostream& operator<<(ostream &output, const Atom &atom)
+    {
+        Json::Writer writer(output, true);
+        writer.write(atom);
+        return output;
+    }
+    
+    //! Retrieves the position of the quote that closes a quoted word, the quotes preceded by a backslash are skipped.
+    static size_t closingQuote(string_view text, size_t pos) noexcept
+    {
+        for(; pos < text.size(); pos++)
+        {
+            if(text[pos] == '\\')
+            {
+                pos++;
             }
-            --indent;
-            for(ulong i = 0; i < indent; i++)
+            else if(text[pos] == '\"')
             {
-                output << '\t';
+                return pos;
             }
-            output << '}';
         }
-        return output;
+        return string_view::npos;
     }
     
-    ostream& operator<<(ostream &output, const Atom &atom)
+    Atom Atom::parseWord(string_view word) noexcept
     {
-        const bool boolalpha = output.flags() & ios::boolalpha;
-        if(!boolalpha)
+        const char* first = word.data();
+        const char* last  = first + word.size();
+        const char* it    = first + (*first == '-' ? 1 : 0);
+        bool digits = false, point = false;
+        for(; it != last; ++it)
         {
-            output << std::boolalpha;
+            if(isdigit((unsigned char)*it))
+            {
+                digits = true;
+            }
+            else if(*it == '.' && !point)
+            {
+                point = true;
+            }
+            else
+            {
+                break;
+            }
         }
-        ulong indent = 0;
-        Atom::toJson(output, atom, indent);
-        if(!boolalpha)
+        
+        if(digits && it == last)
         {
-            output << std::noboolalpha;
+            if(!point)
+            {
+                long value;
+                if(from_chars(first, last, value).ec == errc())
+                {
+                    return Atom(value);
+                }
+            }
+            // The integers that don't fit in a long are parsed as doubles
+            double value;
+            if(from_chars(first, last, value).ec == errc())
+            {
+                return Atom(value);
+            }
         }
-        return output;
+        
+        if(word.find_first_of("\\\"") == string_view::npos)
+        {
+            return Atom(Tag::create(word));
+        }
+        return Atom(Tag::create(jsonUnescape(string(word))));
     }
     
-    Vector Atom::parse(string const& text)
+    Atom Atom::parseQuoted(string_view word) noexcept
     {
-        Vector atoms;
-        const ulong textlen = text.length();
-        string::size_type pos = text.find_first_not_of(' ', 0);
-        
-        while(pos < textlen)
-        {
-            string word;
-            word.reserve(20); // does it more efficient ?
-            bool isTag      = false;
-            bool isNumber   = false;
-            bool isFloat    = false;
-            bool isNegative = false;
-            bool isQuoted   = false;
+        if(word.find('\\') == string_view::npos)
+        {
+            return Atom(Tag::create(word));
+        }
+        return Atom(Tag::create(jsonUnescape(string(word))));
+    }
+    
+    void Atom::parse(string_view text, Vector& atoms)
+    {
+        atoms.clear();
+        const size_t size = text.size();
+        size_t pos = 0;
+        while(pos < size)
+        {
+            // The white spaces between the words are skipped
+            if(text[pos] == ' ')
+            {
+                pos++;
+                continue;
+            }
             
-            while(pos < textlen)
+            if(text[pos] == '\"')
             {
-                const char c = text[pos];
+                const size_t end = closingQuote(text, pos + 1);
+                if(end != string_view::npos)
+                {
+                    // A quoted word is always a tag and preserves the white spaces
+                    atoms.push_back(parseQuoted(text.substr(pos + 1, end - pos - 1)));
+                    pos = end + 1;
+                    continue;
+                }
                 
+                // A quote that can't be closed is ignored
+                if(++pos == size || text[pos] == ' ')
+                {
+                    continue;
+                }
+            }
+            
+            size_t end = text.find(' ', pos);
+            if(end == string_view::npos)
+            {
+                end = size;
+            }
+            atoms.push_back(parseWord(text.substr(pos, end - pos)));
+            pos = end;
+        }
+    }
+    
+    Vector Atom::parse(string_view text)
+    {
+        Vector atoms;
+        parse(text, atoms);
+        return atoms;
+    }
+    
+    // ================================================================================ //
+    //                                      TOKENIZER                                   //
+    // ================================================================================ //
+    
+    Atom::Tokenizer::Tokenizer(string_view terminators) noexcept :
+    m_terminators{},
+    m_state(BETWEEN),
+    m_escape(false)
+    {
+        for(char c : terminators)
+        {
+            m_terminators[(unsigned char)c] = true;
+        }
+    }
+    
+    char const* Atom::Tokenizer::scan(char const* it, char const* const end)
+    {
+        while(it != end)
+        {
+            if(m_state == BETWEEN)
+            {
+                const char c = *it;
+                if(m_terminators[(unsigned char)c])
+                {
+                    return it + 1;
+                }
                 if(c == ' ')
                 {
-                    if(!isQuoted)
-                    {
-                        if(word.empty()) // delete useless white spaces
-                        {
-                            pos++;
-                            continue;
-                        }
-                        else // preserve white space in quoted tags, otherwise break word
-                        {
-                            break;
-                        }
-                    }
+                    ++it;
                 }
                 else if(c == '\"')
                 {
-                    if(isQuoted) // closing quote
-                    {
-                        pos++;
-                        break;
-                    }
-                    
-                    if(word.empty()) // begin quote
-                    {
-                        pos++;
-                        
-                        // ignore if it can not be closed
-                        if(text.find_first_of('\"', pos) != string::npos)
-                            isQuoted = isTag = true;
-                        
-                        continue;
-                    }
+                    m_state = QUOTED;
+                    ++it;
                 }
-                else if(!isTag)
+                else
                 {
-                    if(word.empty() && c == '-')
-                    {
-                        isNegative = true;
-                    }
-                    else if(!isFloat && (word.empty() || isNumber || isNegative) && c == '.')
-                    {
-                        isFloat = true;
-                    }
-                    else if(isdigit(c) && (isNumber || (word.empty() || isNegative || isFloat)))
-                    {
-                        isNumber = true;
-                    }
-                    else
-                    {
-                        isTag = true;
-                        isNumber = isNegative = isFloat = false;
-                    }
+                    m_state = WORD;
                 }
-                
-                word += c;
-                pos++;
+                continue;
             }
             
-            if(!word.empty())
+            // The backslashes only protect the terminators and the quotes, a word still ends at a white space
+            char const* const first = it;
+            bool ended = false;
+            for(; it != end; ++it)
             {
-                if(isNumber)
+                const char c = *it;
+                if(m_escape)
                 {
-                    if(isFloat)
+                    m_escape = false;
+                    if(c == ' ' && m_state == WORD)
                     {
-                        atoms.push_back(Atom(stod(word.c_str())));
-                    }
-                    else
-                    {
-                        atoms.push_back(Atom(stol(word.c_str())));
+                        ended = true;
+                        break;
                     }
                 }
-                else
+                else if(c == '\\')
                 {
-                    atoms.push_back(Atom(Tag::create(jsonUnescape(word))));
+                    m_escape = true;
+                }
+                else if(m_terminators[(unsigned char)c] || (m_state == WORD ? c == ' ' : c == '\"'))
+                {
+                    ended = true;
+                    break;
                 }
             }
+            
+            // The words split between two chunks are kept, the others are parsed from the chunk
+            string_view word(first, size_t(it - first));
+            if(!m_pending.empty() || !ended)
+            {
+                m_pending.append(first, size_t(it - first));
+                word = m_pending;
+            }
+            if(!ended)
+            {
+                return nullptr;
+            }
+            
+            if(m_state == WORD)
+            {
+                m_atoms.push_back(parseWord(word));
+            }
+            else if(*it == '\"')
+            {
+                m_atoms.push_back(parseQuoted(word));
+                ++it;
+            }
+            else
+            {
+                // A quote that isn't closed in its message is ignored
+                Vector atoms;
+                Atom::parse(word, atoms);
+                for(Atom& atom : atoms)
+                {
+                    m_atoms.push_back(move(atom));
+                }
+            }
+            m_pending.clear();
+            m_state = BETWEEN;
+        }
+        return nullptr;
+    }
+    
+    void Atom::Tokenizer::close()
+    {
+        if(m_state == WORD && !m_pending.empty())
+        {
+            m_atoms.push_back(parseWord(m_pending));
+        }
+        else if(m_state == QUOTED)
+        {
+            Vector atoms;
+            Atom::parse(m_pending, atoms);
+            for(Atom& atom : atoms)
+            {
+                m_atoms.push_back(move(atom));
+            }
+        }
+        m_pending.clear();
+        m_state  = BETWEEN;
+        m_escape = false;
+    }
+    
+    void Atom::Tokenizer::reset() noexcept
+    {
+        m_pending.clear();
+        m_atoms.clear();
+        m_state  = BETWEEN;
+        m_escape = false;
+    }
+    
+    // ================================================================================ //
+    //                                      POOL                                        //
+    // ================================================================================ //
+    
+    Atom Atom::Pool::intern(Atom const& atom)
+    {
+        if(atom.m_type != VECTOR && atom.m_type != DICO && atom.m_type != DOUBLES && atom.m_type != FLOATS)
+        {
+            return atom;
         }
         
-        return atoms;
+        // The hash is computed before locking the pool
+        atom.getHash();
+        lock_guard<mutex> guard(m_mutex);
+        return *m_atoms.insert(atom).first;
+    }
+    
+    size_t Atom::Pool::size() const noexcept
+    {
+        lock_guard<mutex> guard(m_mutex);
+        return m_atoms.size();
+    }
+    
+    size_t Atom::Pool::purge() noexcept
+    {
+        lock_guard<mutex> guard(m_mutex);
+        size_t count = 0ul;
+        for(auto it = m_atoms.begin(); it != m_atoms.end();)
+        {
+            ulong refs;
+            switch(it->m_type)
+            {
+                case VECTOR:  refs = it->m_vector->refs.load(memory_order_acquire); break;
+                case DICO:    refs = it->m_dico->refs.load(memory_order_acquire); break;
+                case DOUBLES: refs = it->m_doubles->refs.load(memory_order_acquire); break;
+                default:      refs = it->m_floats->refs.load(memory_order_acquire); break;
+            }
+            if(refs == 1ul)
+            {
+                it = m_atoms.erase(it);
+                count++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return count;
+    }
+    
+    void Atom::Pool::clear() noexcept
+    {
+        lock_guard<mutex> guard(m_mutex);
+        m_atoms.clear();
     }
 }
-
-
-
@@ -25,9 +25,82 @@
 #define __DEF_KIWI_CORE_ATOM__
 
 #include "KiwiTag.h"
+#include "KiwiSmallVector.h"
+#include "KiwiFlatMap.h"
 
 namespace Kiwi
 {
+    // ================================================================================ //
+    //                                      TUPLE                                       //
+    // ================================================================================ //
+    
+    //! The tuple is a small list of numbers.
+    /** The tuple holds up to four numbers stored in place, it's used for the colors, the positions and the sizes. The numbers are stored as floats so a tuple fits inside an atom without allocation : the doubles are rounded to the nearest float and keep about 7 significant digits, so a tuple isn't suited to the values that must be exact. A tuple never holds more than four numbers, the lists that are longer are rejected instead of being truncated.
+     */
+    class Tuple
+    {
+    public:
+        static const ulong capacity = 4ul;
+        
+    private:
+        float           m_values[capacity];
+        unsigned char   m_size;
+        
+    public:
+        
+        //! Constructor.
+        /** Creates an empty tuple.
+         */
+        constexpr Tuple() noexcept : m_values{0.f, 0.f, 0.f, 0.f}, m_size(0) {}
+        
+        //! Constructor.
+        /** Creates a tuple with up to four numbers, a tuple of more numbers doesn't compile. The numbers are converted to floats.
+         @param values The numbers.
+         */
+        template <class ...Values, class = typename enable_if<(sizeof...(Values) <= capacity) && conjunction<is_arithmetic<Values>...>::value>::type>
+        constexpr explicit Tuple(const Values... values) noexcept : m_values{float(values)...}, m_size((unsigned char)sizeof...(Values)) {}
+        
+        //! Retrieve the number of values.
+        inline ulong size() const noexcept {return m_size;}
+        
+        //! Check if the tuple is empty.
+        inline bool empty() const noexcept {return m_size == 0;}
+        
+        //! Append a value, the value is ignored if the tuple is full.
+        /** The function appends a value to the tuple.
+         @param value The value.
+         @return true if the value has been added, false if the tuple is full.
+         */
+        inline bool push_back(const double value) noexcept
+        {
+            if(m_size < capacity)
+            {
+                m_values[m_size++] = float(value);
+                return true;
+            }
+            return false;
+        }
+        
+        inline float& operator[](const ulong i) noexcept {return m_values[i];}
+        inline float operator[](const ulong i) const noexcept {return m_values[i];}
+        inline float* begin() noexcept {return m_values;}
+        inline float const* begin() const noexcept {return m_values;}
+        inline float* end() noexcept {return m_values + m_size;}
+        inline float const* end() const noexcept {return m_values + m_size;}
+        
+        //! Compare the tuple with another.
+        inline bool operator==(Tuple const& other) const noexcept
+        {
+            return m_size == other.m_size && equal(begin(), end(), other.begin());
+        }
+        
+        //! Compare the tuple with another.
+        inline bool operator!=(Tuple const& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+    
     // ================================================================================ //
     //                                      ATOM                                        //
     // ================================================================================ //
@@ -40,7 +113,7 @@ namespace Kiwi
     {
     public:
         
-        enum Type
+        enum Type : unsigned char
         {
             UNDEFINED = 0,
             BOOLEAN   = 1,
@@ -48,111 +121,198 @@ namespace Kiwi
             DOUBLE    = 3,
             TAG       = 4,
             VECTOR    = 5,
-            DICO      = 6
+            DICO      = 6,
+            DOUBLES   = 7,
+            FLOATS    = 8,
+            TUPLE     = 9
         };
         
     private:
-
-        class Quark
+        
+        //! The shared payload of the vector and dico atoms.
+        /** The payload is shared by the copies of an atom and copied only when one of them is modified.
+         */
+        template <class T> class Shared
         {
         public:
-            constexpr inline Quark() noexcept {}
-            virtual inline ~Quark() noexcept {}
-            virtual inline Type getType() const noexcept {return UNDEFINED;}
-            inline bool isUndefined() const noexcept {return getType() == UNDEFINED;}
-            inline bool isBool() const noexcept {return getType() == BOOLEAN;}
-            inline bool isLong() const noexcept {return getType() == LONG;}
-            inline bool isDouble() const noexcept {return getType() == DOUBLE;}
-            inline bool isNumber() const noexcept {return isLong() || isDouble() || isBool();}
-            inline bool isTag() const noexcept {return getType() == TAG;}
-            inline bool isDico() const noexcept{return getType() == DICO;}
-            inline bool isVector() const noexcept {return getType() == VECTOR;}
-            virtual inline bool getBool() const noexcept {return false;}
-            virtual inline long getLong() const noexcept {return 0ul;}
-            virtual inline double getDouble() const noexcept {return 0.;}
-            virtual inline sTag getTag() const noexcept {return Tags::_empty;}
-            virtual inline Vector getVector() const noexcept {return Vector();}
-            virtual inline Dico getDico() const noexcept {return Dico();}
+            mutable atomic<ulong>   refs;
+            mutable atomic<ulong>   hash;
+            T                       value;
+            
+            template <class ...Args> inline Shared(Args&& ...args) noexcept : refs(1ul), hash(0ul), value(forward<Args>(args)...) {}
+            
+            //! Creates a payload, the memory is allocated from the arena of the current thread if any.
+            template <class ...Args> static inline Shared* create(Args&& ...args) noexcept
+            {
+                return new(Arena::allocate(sizeof(Shared))) Shared(forward<Args>(args)...);
+            }
+            
+            //! Increments the reference counter and returns the payload.
+            inline Shared* retain() noexcept
+            {
+                refs.fetch_add(1ul, memory_order_relaxed);
+                return this;
+            }
+            
+            //! Decrements the reference counter and deletes the payload if it isn't used anymore.
+            inline void release() noexcept
+            {
+                if(refs.fetch_sub(1ul, memory_order_acq_rel) == 1ul)
+                {
+                    this->~Shared();
+                    Arena::deallocate(this);
+                }
+            }
+            
+            //! Retrieves a payload that isn't shared, copying the payload if needed.
+            inline Shared* unshare() noexcept
+            {
+                if(refs.load(memory_order_acquire) == 1ul)
+                {
+                    return this;
+                }
+                Shared* copy = create(value);
+                release();
+                return copy;
+            }
         };
         
-        class QuarkBool : public Quark
+        // The scalar values, the tag and the tuple are stored in place, only the containers are allocated
+        Type            m_type;
+        unsigned char   m_arity = 0;
+        union
         {
-        public:
-            const bool val;
-            inline QuarkBool(QuarkBool const& _val) noexcept : val(_val.val) {}
-            inline QuarkBool(bool const& _val) noexcept : val(_val) {}
-            inline Type getType() const noexcept override {return BOOLEAN;}
-            inline bool getBool() const noexcept override {return val;}
-            inline long getLong() const noexcept override {return long(val);}
-            inline double getDouble() const noexcept override {return double(val);}
+            float               m_tuple[Tuple::capacity];
+            bool                m_bool;
+            long                m_long;
+            double              m_double;
+            sTag                m_tag;
+            Shared<Vector>*     m_vector;
+            Shared<Dico>*       m_dico;
+            Shared<Doubles>*    m_doubles;
+            Shared<Floats>*     m_floats;
         };
         
-        class QuarkLong : public Quark
+        //! Releases the value and leaves the atom undefined.
+        inline void clear() noexcept
         {
-        public:
-            const long val;
-            inline QuarkLong(QuarkLong const& _val) noexcept : val(_val.val) {}
-            inline  QuarkLong(long const& _val) noexcept : val(_val) {}
-            inline Type getType() const noexcept override {return LONG;}
-            inline bool getBool() const noexcept override {return bool(val);}
-            inline long getLong() const noexcept override {return val;}
-            inline double getDouble() const noexcept override {return double(val);}
-        };
+            if(m_type == TAG)
+            {
+                m_tag.~TagPtr();
+            }
+            else if(m_type == VECTOR)
+            {
+                m_vector->release();
+            }
+            else if(m_type == DICO)
+            {
+                m_dico->release();
+            }
+            else if(m_type == DOUBLES)
+            {
+                m_doubles->release();
+            }
+            else if(m_type == FLOATS)
+            {
+                m_floats->release();
+            }
+            m_type = UNDEFINED;
+        }
         
-        class QuarkDouble : public Quark
+        //! Retrieves the value of a payload to modify it, copying the payload if it is shared and resetting its hash.
+        template <class T> static inline T& unshare(Shared<T>*& payload) noexcept
         {
-        public:
-            const double val;
-            inline QuarkDouble(QuarkDouble const& _val) noexcept : val(_val.val) {}
-            inline QuarkDouble(double const& _val) noexcept : val(_val) {}
-            inline Type getType() const noexcept override {return DOUBLE;}
-            inline bool getBool() const noexcept override {return bool(val);}
-            inline long getLong() const noexcept override {return long(val);}
-            inline double getDouble() const noexcept override {return val;}
-        };
+            payload = payload->unshare();
+            payload->hash.store(0ul, memory_order_relaxed);
+            return payload->value;
+        }
+        
+        //! Retrieves the hash of a payload, the hash is computed once and cached in the payload.
+        template <class T> static ulong cachedHash(Shared<T> const& payload) noexcept;
+
         
-        class QuarkTag : public Quark
+        //! Takes the value of another atom and leaves it undefined, the atom must be undefined.
+        inline void steal(Atom& other) noexcept
         {
-        public:
-            const sTag val;
-            inline QuarkTag(QuarkTag const& _val) noexcept : val(_val.val) {}
-            inline QuarkTag(const sTag _val) noexcept : val(_val) {}
-            inline Type getType() const noexcept override {return TAG;}
-            inline sTag getTag() const noexcept override {return val;}
-        };
+            switch(other.m_type)
+            {
+                case BOOLEAN: m_bool = other.m_bool; break;
+                case LONG:    m_long = other.m_long; break;
+                case DOUBLE:  m_double = other.m_double; break;
+                case TAG:     new(&m_tag) sTag(move(other.m_tag)); other.m_tag.~TagPtr(); break;
+                case VECTOR:  m_vector = other.m_vector; break;
+                case DICO:    m_dico = other.m_dico; break;
+                case DOUBLES: m_doubles = other.m_doubles; break;
+                case FLOATS:  m_floats = other.m_floats; break;
+                case TUPLE:   memcpy(m_tuple, other.m_tuple, sizeof(m_tuple)); m_arity = other.m_arity; break;
+                default:      break;
+            }
+            m_type = other.m_type;
+            other.m_type = UNDEFINED;
+        }
         
-        class QuarkVector : public Quark
+        //! Copies the value of another atom, the atom must be undefined.
+        void copy(Atom const& other) noexcept;
+        
+        //! Stores a tuple in place.
+        inline void setTuple(Tuple const& tuple) noexcept
         {
-        public:
-            Vector val;
-            inline QuarkVector(QuarkVector const& _val) noexcept : val(_val.val) {}
-            inline QuarkVector(Vector const& _val) noexcept : val(_val) {}
-            inline QuarkVector(Vector::iterator first, Vector::iterator last) noexcept : val(first, last) {}
-            inline QuarkVector(Vector&& _val) noexcept {swap(val, _val);}
-            inline QuarkVector(initializer_list<Atom> il) noexcept : val(il) {}
-            inline ~QuarkVector() noexcept {val.clear();}
-            inline Type getType() const noexcept override {return VECTOR;}
-            inline Vector getVector() const noexcept override {return val;}
-        };
+            m_arity = (unsigned char)tuple.size();
+            for(ulong i = 0; i < Tuple::capacity; i++)
+            {
+                m_tuple[i] = i < tuple.size() ? tuple[i] : 0.f;
+            }
+        }
         
-        class QuarkDico : public Quark
+        //! Retrieves the value as a boolean.
+        inline bool getBool() const noexcept
         {
-        public:
-            Dico val;
-            inline QuarkDico(QuarkDico const& _val) noexcept : val(_val.val) {}
-            inline QuarkDico(Dico const& _val) noexcept : val(_val) {}
-            inline QuarkDico(Dico::iterator first, Dico::iterator last) noexcept : val(first, last) {}
-            inline QuarkDico(Dico&& _val) noexcept {swap(val, _val);}
-            inline QuarkDico(initializer_list<pair<const sTag, Atom>> il) noexcept : val(il) {}
-            inline ~QuarkDico() noexcept {val.clear();}
-            inline Type getType() const noexcept override {return DICO;}
-            inline Dico getDico() const noexcept override {return val;}
-        };
+            switch(m_type)
+            {
+                case BOOLEAN: return m_bool;
+                case LONG:    return bool(m_long);
+                case DOUBLE:  return bool(m_double);
+                default:      return false;
+            }
+        }
         
-        Quark* m_quark;
+        //! Retrieves the value as a long.
+        inline long getLong() const noexcept
+        {
+            switch(m_type)
+            {
+                case BOOLEAN: return long(m_bool);
+                case LONG:    return m_long;
+                case DOUBLE:  return long(m_double);
+                default:      return 0l;
+            }
+        }
+        
+        //! Retrieves the value as a double.
+        inline double getDouble() const noexcept
+        {
+            switch(m_type)
+            {
+                case BOOLEAN: return double(m_bool);
+                case LONG:    return double(m_long);
+                case DOUBLE:  return m_double;
+                default:      return 0.;
+            }
+        }
+        
+        //! Creates an atom with an unquoted word, a number if the word is only made of digits with an optional sign and point, otherwise a tag.
+        static Atom parseWord(string_view word) noexcept;
+        
+        //! Creates a tag atom with the content of a quoted word.
+        static Atom parseQuoted(string_view word) noexcept;
         
     public:
         
+        class Tokenizer;
+        class Pool;
+        struct Hash;
+        struct Identical;
+        
         // ================================================================================ //
         //                                      ATOM                                        //
         // ================================================================================ //
@@ -160,230 +320,395 @@ namespace Kiwi
         //! Constructor.
         /** The function allocates an undefined atom.
          */
-        inline Atom() noexcept : m_quark(new Quark()) {}
+        inline Atom() noexcept : m_type(UNDEFINED) {}
         
         //! Constructor with another atom.
         /** The function allocates the atom with an atom.
          */
-        inline Atom(Atom&& other) noexcept : m_quark(move(other.m_quark)) {other.m_quark = new Quark();}
+        inline Atom(Atom&& other) noexcept : m_type(UNDEFINED) {steal(other);}
         
         //! Constructor with another atom.
         /** The function allocates the atom with an atom.
          */
-        Atom(Atom const& other) noexcept;
+        inline Atom(Atom const& other) noexcept : m_type(UNDEFINED) {copy(other);}
         
         //! Constructor with a boolean value.
         /** The function allocates the atom with a long value created with a boolean value.
          @param value The value.
          */
-        inline Atom(const bool value) noexcept : m_quark(new QuarkBool(value)) {}
+        inline Atom(const bool value) noexcept : m_type(BOOLEAN), m_bool(value) {}
         
         //! Constructor with a long value.
         /** The function allocates the atom with a long value.
          @param value The value.
          */
-        inline Atom(const int value) noexcept : m_quark(new QuarkLong(long(value))) {}
+        inline Atom(const int value) noexcept : m_type(LONG), m_long(long(value)) {}
         
         //! Constructor with a long value.
         /** The function allocates the atom with a long value.
          @param value The value.
          */
-        inline Atom(const long value) noexcept : m_quark(new QuarkLong(value)) {}
+        inline Atom(const long value) noexcept : m_type(LONG), m_long(value) {}
         
         //! Constructor with a double value.
         /** The function allocates the atom with a double value.
          @param value The value.
          */
-        inline Atom(const float value) noexcept : m_quark(new QuarkDouble(double(value))) {}
+        inline Atom(const float value) noexcept : m_type(DOUBLE), m_double(double(value)) {}
         
         //! Constructor with a double value.
         /** The function allocates the atom with a double value.
          @param value The value.
          */
-        inline Atom(const double value) noexcept : m_quark(new QuarkDouble(value)) {}
+        inline Atom(const double value) noexcept : m_type(DOUBLE), m_double(value) {}
         
         //! Constructor with a string.
         /** The function allocates the atom with a tag created with a string.
          @param tag The tag.
          */
-        inline Atom(const char* tag) noexcept : m_quark(new QuarkTag(Tag::create(tag))) {}
+        inline Atom(const char* tag) noexcept : m_type(TAG), m_tag(Tag::create(tag)) {}
         
         //! Constructor with a string.
         /** The function allocates the atom with a tag created with a string.
          @param tag The tag.
          */
-        inline Atom(string const& tag) noexcept : m_quark(new QuarkTag(Tag::create(tag))) {}
+        inline Atom(string const& tag) noexcept : m_type(TAG), m_tag(Tag::create(tag)) {}
         
         //! Constructor with a string.
         /** The function allocates the atom with a tag created with a string.
          @param tag The tag.
          */
-        inline Atom(string&& tag) noexcept : m_quark(new QuarkTag(Tag::create(forward<string>(tag)))) {}
+        inline Atom(string&& tag) noexcept : m_type(TAG), m_tag(Tag::create(forward<string>(tag))) {}
         
+        //! Constructor with a string.
+        /** The function allocates the atom with a tag created with a string view.
+         @param tag The tag.
+         */
+        inline Atom(string_view tag) noexcept : m_type(TAG), m_tag(Tag::create(tag)) {}
+
         //! Constructor with a tag.
         /** The function allocates the atom with a tag.
          */
-        inline Atom(const sTag tag) noexcept : m_quark(new QuarkTag(tag)) {}
+        inline Atom(const sTag tag) noexcept : m_type(TAG), m_tag(tag) {}
         
         //! Constructor with a vector of atoms.
         /** The function allocates the atom with a vector of atoms.
          */
-        inline Atom(Vector const& atoms) noexcept : m_quark(new QuarkVector(atoms)) {}
+        inline Atom(Vector const& atoms) noexcept : m_type(VECTOR), m_vector(Shared<Vector>::create(atoms)) {}
         
         //! Constructor with a vector of atoms.
         /** The function allocates the atom with a vector of atoms.
          */
-        inline Atom(Vector&& atoms) noexcept : m_quark(new QuarkVector(forward<Vector>(atoms))) {}
+        inline Atom(Vector&& atoms) noexcept : m_type(VECTOR), m_vector(Shared<Vector>::create(forward<Vector>(atoms))) {}
         
         //! Constructor with a vector of atoms.
-        /** The function allocates the atom with a vector of atoms.
+        /** The function allocates the atom with a vector of atoms created with a range of a vector.
          */
-        inline Atom(Vector::iterator first, Vector::iterator last) noexcept : m_quark(new QuarkVector(first, last)) {}
+        inline Atom(Atom* first, Atom* last) noexcept : m_type(VECTOR), m_vector(Shared<Vector>::create(first, last)) {}
         
         //! Constructor with a vector of atoms.
         /** The function allocates the atom with a vector of atoms.
          */
-        inline Atom(initializer_list<Atom> il) noexcept : m_quark(new QuarkVector(il)) {}
+        inline Atom(initializer_list<Atom> il) noexcept : m_type(VECTOR), m_vector(Shared<Vector>::create(il)) {}
         
         //! Constructor with a map of atoms.
         /** The function allocates the atom with a vector of atoms.
          */
-        inline Atom(Dico const& atoms) noexcept : m_quark(new QuarkDico(atoms)) {}
+        inline Atom(Dico const& atoms) noexcept : m_type(DICO), m_dico(Shared<Dico>::create(atoms)) {}
         
         //! Constructor with a map of atoms.
         /** The function allocates the atom with a vector of atoms.
          */
-        inline Atom(Dico&& atoms) noexcept  : m_quark(new QuarkDico(forward<Dico>(atoms))) {}
+        inline Atom(Dico&& atoms) noexcept  : m_type(DICO), m_dico(Shared<Dico>::create(forward<Dico>(atoms))) {}
         
         //! Constructor with a map of atoms.
         /** The function allocates the atom with a vector of atoms.
          */
-        inline Atom(Dico::iterator first, Dico::iterator last) noexcept : m_quark(new QuarkDico(first, last)) {}
+        inline Atom(Dico::iterator first, Dico::iterator last) noexcept : m_type(DICO), m_dico(Shared<Dico>::create(first, last)) {}
         
         //! Constructor with a map of atoms.
         /** The function allocates the atom with a vector of atoms.
          */
-        inline Atom(initializer_list<pair<const sTag, Atom>> il) noexcept : m_quark(new QuarkDico(il)) {}
+        inline Atom(initializer_list<pair<const sTag, Atom>> il) noexcept : m_type(DICO), m_dico(Shared<Dico>::create(il)) {}
+        
+        //! Constructor with a buffer of doubles.
+        /** The function allocates the atom with a buffer of doubles.
+         */
+        inline Atom(Doubles const& values) noexcept : m_type(DOUBLES), m_doubles(Shared<Doubles>::create(values)) {}
+        
+        //! Constructor with a buffer of doubles.
+        /** The function allocates the atom with a buffer of doubles.
+         */
+        inline Atom(Doubles&& values) noexcept : m_type(DOUBLES), m_doubles(Shared<Doubles>::create(forward<Doubles>(values))) {}
+        
+        //! Constructor with a buffer of floats.
+        /** The function allocates the atom with a buffer of floats.
+         */
+        inline Atom(Floats const& values) noexcept : m_type(FLOATS), m_floats(Shared<Floats>::create(values)) {}
+        
+        //! Constructor with a buffer of floats.
+        /** The function allocates the atom with a buffer of floats.
+         */
+        inline Atom(Floats&& values) noexcept : m_type(FLOATS), m_floats(Shared<Floats>::create(forward<Floats>(values))) {}
+        
+        //! Constructor with a tuple.
+        /** The function initializes the atom with a tuple, the tuple is stored in place.
+         */
+        inline Atom(Tuple const& tuple) noexcept : m_type(TUPLE) {setTuple(tuple);}
         
         //! Destructor.
-        /** Doesn't perform anything.
+        /** Frees the vector or the map of atoms.
          */
-        inline ~Atom() noexcept {delete m_quark;}
+        inline ~Atom() noexcept {clear();}
         
         //! Retrieve the type of the atom.
         /** The function retrieves the type of the atom.
          @return The type of the atom as a type.
          */
-        inline Type getType() const noexcept {return m_quark->getType();}
+        inline Type getType() const noexcept {return m_type;}
         
         //! Check if the atom is undefined.
         /** The function checks if the atom is undefined.
          @return    true if the atom is undefined.
          */
-        inline bool isUndefined() const noexcept {return m_quark->isUndefined();}
+        inline bool isUndefined() const noexcept {return m_type == UNDEFINED;}
         
         //! Check if the atom is of type bool.
         /** The function checks if the atom is of type bool.
          @return    true if the atom is a bool.
          */
-        inline bool isBool() const noexcept {return m_quark->isBool();}
+        inline bool isBool() const noexcept {return m_type == BOOLEAN;}
         
         //! Check if the atom is of type long.
         /** The function checks if the atom is of type long.
          @return    true if the atom is a long.
          */
-        inline bool isLong() const noexcept {return m_quark->isLong();}
+        inline bool isLong() const noexcept {return m_type == LONG;}
         
         //! Check if the atom is of type double.
         /** The function checks if the atom is of type double.
          @return    true if the atom is a double.
          */
-        inline bool isDouble() const noexcept {return m_quark->isDouble();}
+        inline bool isDouble() const noexcept {return m_type == DOUBLE;}
         
         //! Checks if the atom is of type long or double.
         /** The function checks if the atom is of type long or double.
          @return    true if the atom is a long or a double.
          */
-        inline bool isNumber() const noexcept {return m_quark->isNumber();}
+        inline bool isNumber() const noexcept {return m_type >= BOOLEAN && m_type <= DOUBLE;}
         
         //! Check if the atom is of type tag.
         /** The function checks if the atom is of type tag.
          @return    true if the atom is a tag.
          */
-        inline bool isTag() const noexcept {return m_quark->isTag();}
+        inline bool isTag() const noexcept {return m_type == TAG;}
         
         //! Check if the atom is of type vector.
         /** The function checks if the atom is of type vector.
          @return    true if the atom is a vector.
          */
-        inline bool isVector() const noexcept {return m_quark->isVector();}
+        inline bool isVector() const noexcept {return m_type == VECTOR;}
         
         //! Check if the atom is of type map.
         /** The function checks if the atom is of type map.
          @return    true if the atom is a map.
          */
-        inline bool isDico() const noexcept {return m_quark->isDico();}
+        inline bool isDico() const noexcept {return m_type == DICO;}
+        
+        //! Check if the atom is a buffer of doubles.
+        /** The function checks if the atom is a buffer of doubles.
+         @return    true if the atom is a buffer of doubles.
+         */
+        inline bool isDoubles() const noexcept {return m_type == DOUBLES;}
+        
+        //! Check if the atom is a buffer of floats.
+        /** The function checks if the atom is a buffer of floats.
+         @return    true if the atom is a buffer of floats.
+         */
+        inline bool isFloats() const noexcept {return m_type == FLOATS;}
+        
+        //! Check if the atom is a buffer of numbers.
+        /** The function checks if the atom is a buffer of doubles or of floats.
+         @return    true if the atom is a buffer.
+         */
+        inline bool isBuffer() const noexcept {return m_type == DOUBLES || m_type == FLOATS;}
+        
+        //! Check if the atom is a tuple.
+        /** The function checks if the atom is a tuple.
+         @return    true if the atom is a tuple.
+         */
+        inline bool isTuple() const noexcept {return m_type == TUPLE;}
         
         //! Cast the atom to a boolean.
         /** The function casts the atom to a boolean.
          @return An boolean value if the atom is a digit otherwise 0.
          */
-        inline operator bool() const noexcept {return m_quark->getBool();}
+        inline operator bool() const noexcept {return getBool();}
         
         //! Cast the atom to an int.
         /** The function casts the atom to an int.
          @return An int value if the atom is a digit otherwise 0.
          */
-        inline operator int() const noexcept {return int(m_quark->getLong());}
+        inline operator int() const noexcept {return int(getLong());}
         
         //! Cast the atom to a long.
         /** The function casts the atom to a long.
          @return A long value if the atom is a digit otherwise 0.
          */
-        inline operator long() const noexcept {return m_quark->getLong();}
+        inline operator long() const noexcept {return getLong();}
         
         //! Cast the atom to a long.
         /** The function casts the atom to a long.
          @return A long value if the atom is a digit otherwise 0.
          */
-        inline operator ulong() const noexcept {return ulong(m_quark->getLong());}
+        inline operator ulong() const noexcept {return ulong(getLong());}
         
         //! Cast the atom to a float.
         /** The function casts the atom to a float.
          @return A float value if the atom is a digit otherwise 0.
          */
-        inline operator float() const noexcept {return float(m_quark->getDouble());}
+        inline operator float() const noexcept {return float(getDouble());}
         
         //! Cast the atom to a double.
         /** The function casts the atom to a double.
          @return A double value if the atom is a digit otherwise 0.
          */
-        inline operator double() const noexcept {return m_quark->getDouble();}
+        inline operator double() const noexcept {return getDouble();}
         
         //! Cast the atom to a tag.
         /** The function casts the atom to a tag.
          @return A tag if the atom is a tag otherwise a nullptr.
          */
-        inline operator sTag() const noexcept {return m_quark->getTag();}
+        inline operator sTag() const noexcept {return m_type == TAG ? m_tag : Tags::_empty;}
         
         //! Cast the atom to a vector of atoms.
         /** The function casts the atom to a vector of atoms.
          @return A vector of atoms.
          */
-        inline operator Vector() const noexcept {return m_quark->getVector();}
+        inline operator Vector() const noexcept {return getVector();}
         
         //! Cast the atom to a map of atoms.
         /** The function casts the atom to a map of atoms.
          @return A map of atoms.
          */
-        inline operator Dico() const noexcept {return m_quark->getDico();}
+        inline operator Dico() const noexcept {return getDico();}
+        
+        //! Cast the atom to a tuple.
+        /** The function casts the atom to a tuple, the numbers of a vector or a buffer are converted to floats.
+         @return A tuple, empty if the atom isn't a tuple, a vector or a buffer or if it has more than four numbers.
+         */
+        operator Tuple() const noexcept;
+        
+        //! Retrieve the vector of atoms.
+        /** The function retrieves a reference to the vector of atoms without copying it. The reference is valid as long as the atom isn't modified.
+         @return The vector of atoms if the atom is a vector otherwise an empty vector.
+         */
+        inline Vector const& getVector() const noexcept
+        {
+            static const Vector empty;
+            return m_type == VECTOR ? m_vector->value : empty;
+        }
+        
+        //! Retrieve the map of atoms.
+        /** The function retrieves a reference to the map of atoms without copying it. The reference is valid as long as the atom isn't modified.
+         @return The map of atoms if the atom is a dico otherwise an empty map.
+         */
+        inline Dico const& getDico() const noexcept
+        {
+            static const Dico empty;
+            return m_type == DICO ? m_dico->value : empty;
+        }
+        
+        //! Retrieve the vector of atoms to modify it.
+        /** The function retrieves the vector of atoms to modify it in place. If the vector is shared with other atoms, it is copied first so the other atoms aren't modified. The pointer is valid as long as the atom isn't assigned.
+         @return The vector of atoms if the atom is a vector otherwise a nullptr.
+         */
+        inline Vector* editVector() noexcept
+        {
+            return m_type == VECTOR ? &unshare(m_vector) : nullptr;
+        }
+        
+        //! Retrieve the map of atoms to modify it.
+        /** The function retrieves the map of atoms to modify it in place. If the map is shared with other atoms, it is copied first so the other atoms aren't modified. The pointer is valid as long as the atom isn't assigned.
+         @return The map of atoms if the atom is a dico otherwise a nullptr.
+         */
+        inline Dico* editDico() noexcept
+        {
+            return m_type == DICO ? &unshare(m_dico) : nullptr;
+        }
+        
+        //! Retrieve the buffer of doubles.
+        /** The function retrieves a reference to the buffer of doubles without copying it. The reference is valid as long as the atom isn't modified.
+         @return The buffer of doubles if the atom is a buffer of doubles otherwise an empty buffer.
+         */
+        inline Doubles const& getDoubles() const noexcept
+        {
+            static const Doubles empty;
+            return m_type == DOUBLES ? m_doubles->value : empty;
+        }
+        
+        //! Retrieve the buffer of floats.
+        /** The function retrieves a reference to the buffer of floats without copying it. The reference is valid as long as the atom isn't modified.
+         @return The buffer of floats if the atom is a buffer of floats otherwise an empty buffer.
+         */
+        inline Floats const& getFloats() const noexcept
+        {
+            static const Floats empty;
+            return m_type == FLOATS ? m_floats->value : empty;
+        }
+        
+        //! Retrieve the buffer of doubles to modify it.
+        /** The function retrieves the buffer of doubles to modify it in place. If the buffer is shared with other atoms, it is copied first so the other atoms aren't modified. The pointer is valid as long as the atom isn't assigned.
+         @return The buffer of doubles if the atom is a buffer of doubles otherwise a nullptr.
+         */
+        inline Doubles* editDoubles() noexcept
+        {
+            return m_type == DOUBLES ? &unshare(m_doubles) : nullptr;
+        }
+        
+        //! Retrieve the buffer of floats to modify it.
+        /** The function retrieves the buffer of floats to modify it in place. If the buffer is shared with other atoms, it is copied first so the other atoms aren't modified. The pointer is valid as long as the atom isn't assigned.
+         @return The buffer of floats if the atom is a buffer of floats otherwise a nullptr.
+         */
+        inline Floats* editFloats() noexcept
+        {
+            return m_type == FLOATS ? &unshare(m_floats) : nullptr;
+        }
+        
+        //! Convert the atom to a vector of atoms.
+        /** The function converts the numbers of a buffer or a tuple to a vector of atoms, a vector is copied.
+         @return The vector of atoms, empty if the atom isn't a vector, a buffer or a tuple.
+         */
+        Vector toVector() const noexcept;
+        
+        //! Convert the atom to a buffer of doubles.
+        /** The function converts the numbers of a vector, a tuple or a buffer of floats to a buffer of doubles, the elements of a vector that aren't numbers become zero, a buffer of doubles is copied.
+         @return The buffer of doubles, empty if the atom isn't a vector, a buffer or a tuple.
+         */
+        Doubles toDoubles() const noexcept;
+        
+        //! Convert the atom to a buffer of floats.
+        /** The function converts the numbers of a vector, a tuple or a buffer of doubles to a buffer of floats, the elements of a vector that aren't numbers become zero, a buffer of floats is copied.
+         @return The buffer of floats, empty if the atom isn't a vector, a buffer or a tuple.
+         */
+        Floats toFloats() const noexcept;
         
         //! Set up the atom with another atom.
         /** The function sets up the atom with another atom.
          @param other   The other atom.
          @return An atom.
          */
-        Atom& operator=(Atom const& other) noexcept;
+        inline Atom& operator=(Atom const& other) noexcept
+        {
+            if(this != &other)
+            {
+                // The other atom can be owned by this one
+                Atom atom(other);
+                clear();
+                steal(atom);
+            }
+            return *this;
+        }
         
         //! Set up the atom with another atom.
         /** The function sets up the atom with another atom.
@@ -392,7 +717,13 @@ namespace Kiwi
          */
         Atom& operator=(Atom&& other) noexcept
         {
-            swap(m_quark, other.m_quark);
+            if(this != &other)
+            {
+                // The other atom can be owned by this one
+                Atom atom(move(other));
+                clear();
+                steal(atom);
+            }
             return *this;
         }
         
@@ -403,8 +734,9 @@ namespace Kiwi
          */
         inline Atom& operator=(const bool value) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkBool(value);
+            clear();
+            m_type = BOOLEAN;
+            m_bool = value;
             return *this;
         }
         
@@ -415,8 +747,9 @@ namespace Kiwi
          */
         inline Atom& operator=(const int value) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkLong((long)value);
+            clear();
+            m_type = LONG;
+            m_long = long(value);
             return *this;
         }
         
@@ -427,8 +760,9 @@ namespace Kiwi
          */
         inline Atom& operator=(const long value) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkLong(value);
+            clear();
+            m_type = LONG;
+            m_long = value;
             return *this;
         }
         
@@ -439,8 +773,9 @@ namespace Kiwi
          */
         inline Atom& operator=(const float value) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkDouble((float)value);
+            clear();
+            m_type = DOUBLE;
+            m_double = double(value);
             return *this;
         }
         
@@ -451,8 +786,9 @@ namespace Kiwi
          */
         inline Atom& operator=(const double value) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkDouble(value);
+            clear();
+            m_type = DOUBLE;
+            m_double = value;
             return *this;
         }
         
@@ -463,8 +799,10 @@ namespace Kiwi
          */
         inline Atom& operator=(char const* tag) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkTag(Tag::create(tag));
+            sTag ntag = Tag::create(tag);
+            clear();
+            new(&m_tag) sTag(move(ntag));
+            m_type = TAG;
             return *this;
         }
         
@@ -475,8 +813,10 @@ namespace Kiwi
          */
         inline Atom& operator=(string const& tag) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkTag(Tag::create(tag));
+            sTag ntag = Tag::create(tag);
+            clear();
+            new(&m_tag) sTag(move(ntag));
+            m_type = TAG;
             return *this;
         }
         
@@ -487,8 +827,10 @@ namespace Kiwi
          */
         inline Atom& operator=(string&& tag) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkTag(Tag::create(forward<string>(tag)));
+            sTag ntag = Tag::create(forward<string>(tag));
+            clear();
+            new(&m_tag) sTag(move(ntag));
+            m_type = TAG;
             return *this;
         }
         
@@ -499,8 +841,9 @@ namespace Kiwi
          */
         inline Atom& operator=(sTag tag) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkTag(tag);
+            clear();
+            new(&m_tag) sTag(move(tag));
+            m_type = TAG;
             return *this;
         }
         
@@ -511,8 +854,10 @@ namespace Kiwi
          */
         inline Atom& operator=(Vector const& atoms) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkVector(atoms);
+            Shared<Vector>* vector = Shared<Vector>::create(atoms);
+            clear();
+            m_vector = vector;
+            m_type = VECTOR;
             return *this;
         }
         
@@ -523,8 +868,10 @@ namespace Kiwi
          */
         inline Atom& operator=(Vector&& atoms) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkVector(forward<Vector>(atoms));
+            Shared<Vector>* vector = Shared<Vector>::create(forward<Vector>(atoms));
+            clear();
+            m_vector = vector;
+            m_type = VECTOR;
             return *this;
         }
         
@@ -535,8 +882,10 @@ namespace Kiwi
          */
         inline Atom& operator=(initializer_list<Atom> il) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkVector(il);
+            Shared<Vector>* vector = Shared<Vector>::create(il);
+            clear();
+            m_vector = vector;
+            m_type = VECTOR;
             return *this;
         }
         
@@ -547,8 +896,10 @@ namespace Kiwi
          */
         inline Atom& operator=(Dico const& atoms) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkDico(atoms);
+            Shared<Dico>* dico = Shared<Dico>::create(atoms);
+            clear();
+            m_dico = dico;
+            m_type = DICO;
             return *this;
         }
         
@@ -559,8 +910,10 @@ namespace Kiwi
          */
         inline Atom& operator=(Dico&& atoms) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkDico(forward<Dico>(atoms));
+            Shared<Dico>* dico = Shared<Dico>::create(forward<Dico>(atoms));
+            clear();
+            m_dico = dico;
+            m_type = DICO;
             return *this;
         }
         
@@ -571,8 +924,79 @@ namespace Kiwi
          */
         inline Atom& operator=(initializer_list<pair<const sTag, Atom>> il) noexcept
         {
-            delete m_quark;
-            m_quark = new QuarkDico(il);
+            Shared<Dico>* dico = Shared<Dico>::create(il);
+            clear();
+            m_dico = dico;
+            m_type = DICO;
+            return *this;
+        }
+        
+        //! Set up the atom with a buffer of doubles.
+        /** The function sets up the atom with a buffer of doubles.
+         @param values   The buffer of doubles.
+         @return An atom.
+         */
+        inline Atom& operator=(Doubles const& values) noexcept
+        {
+            Shared<Doubles>* doubles = Shared<Doubles>::create(values);
+            clear();
+            m_doubles = doubles;
+            m_type = DOUBLES;
+            return *this;
+        }
+        
+        //! Set up the atom with a buffer of doubles.
+        /** The function sets up the atom with a buffer of doubles.
+         @param values   The buffer of doubles.
+         @return An atom.
+         */
+        inline Atom& operator=(Doubles&& values) noexcept
+        {
+            Shared<Doubles>* doubles = Shared<Doubles>::create(forward<Doubles>(values));
+            clear();
+            m_doubles = doubles;
+            m_type = DOUBLES;
+            return *this;
+        }
+        
+        //! Set up the atom with a buffer of floats.
+        /** The function sets up the atom with a buffer of floats.
+         @param values   The buffer of floats.
+         @return An atom.
+         */
+        inline Atom& operator=(Floats const& values) noexcept
+        {
+            Shared<Floats>* floats = Shared<Floats>::create(values);
+            clear();
+            m_floats = floats;
+            m_type = FLOATS;
+            return *this;
+        }
+        
+        //! Set up the atom with a buffer of floats.
+        /** The function sets up the atom with a buffer of floats.
+         @param values   The buffer of floats.
+         @return An atom.
+         */
+        inline Atom& operator=(Floats&& values) noexcept
+        {
+            Shared<Floats>* floats = Shared<Floats>::create(forward<Floats>(values));
+            clear();
+            m_floats = floats;
+            m_type = FLOATS;
+            return *this;
+        }
+        
+        //! Set up the atom with a tuple.
+        /** The function sets up the atom with a tuple.
+         @param tuple   The tuple.
+         @return An atom.
+         */
+        inline Atom& operator=(Tuple const& tuple) noexcept
+        {
+            clear();
+            setTuple(tuple);
+            m_type = TUPLE;
             return *this;
         }
         
@@ -589,27 +1013,39 @@ namespace Kiwi
             }
             else if(other.isBool() && isNumber())
             {
-                return m_quark->getBool() == other.m_quark->getBool();
+                return getBool() == other.getBool();
             }
             else if(other.isLong() && isNumber())
             {
-                return m_quark->getLong() == other.m_quark->getLong();
+                return getLong() == other.getLong();
             }
             else if(other.isDouble() && isNumber())
             {
-                return m_quark->getDouble() == other.m_quark->getDouble();
+                return getDouble() == other.getDouble();
             }
             else if(other.isTag() && isTag())
             {
-                return m_quark->getTag() == other.m_quark->getTag();
+                return m_tag == other.m_tag;
             }
             else if(other.isVector() && isVector())
             {
-                return m_quark->getVector() == other.m_quark->getVector();
+                return m_vector == other.m_vector || m_vector->value == other.m_vector->value;
             }
             else if(other.isDico() && isDico())
             {
-                return m_quark->getDico() == other.m_quark->getDico();
+                return m_dico == other.m_dico || m_dico->value == other.m_dico->value;
+            }
+            else if(other.isDoubles() && isDoubles())
+            {
+                return m_doubles == other.m_doubles || m_doubles->value == other.m_doubles->value;
+            }
+            else if(other.isFloats() && isFloats())
+            {
+                return m_floats == other.m_floats || m_floats->value == other.m_floats->value;
+            }
+            else if(other.isTuple() && isTuple())
+            {
+                return m_arity == other.m_arity && equal(m_tuple, m_tuple + m_arity, other.m_tuple);
             }
             else
             {
@@ -626,7 +1062,7 @@ namespace Kiwi
         {
             if(isNumber())
             {
-                return m_quark->getBool() == value;
+                return getBool() == value;
             }
             else
             {
@@ -643,7 +1079,7 @@ namespace Kiwi
         {
             if(isNumber())
             {
-                return m_quark->getLong() == (long)value;
+                return getLong() == (long)value;
             }
             else
             {
@@ -660,7 +1096,7 @@ namespace Kiwi
         {
             if(isNumber())
             {
-                return m_quark->getLong() == value;
+                return getLong() == value;
             }
             else
             {
@@ -677,7 +1113,7 @@ namespace Kiwi
         {
             if(isNumber())
             {
-                return m_quark->getDouble() == (double)value;
+                return getDouble() == (double)value;
             }
             else
             {
@@ -694,7 +1130,7 @@ namespace Kiwi
         {
             if(isNumber())
             {
-                return m_quark->getDouble() == value;
+                return getDouble() == value;
             }
             else
             {
@@ -732,7 +1168,7 @@ namespace Kiwi
         {
             if(isVector())
             {
-                return m_quark->getVector() == vector;
+                return m_vector->value == vector;
             }
             else
             {
@@ -749,7 +1185,7 @@ namespace Kiwi
         {
             if(isDico())
             {
-                return m_quark->getDico() == dico;
+                return m_dico->value == dico;
             }
             else
             {
@@ -847,7 +1283,26 @@ namespace Kiwi
             return !(*this == dico);
         }
         
-        static ostream& toJson(ostream &output, const Atom &atom, ulong& indent);
+        //! Retrieve the hash of the atom.
+        /** The function retrieves a hash of the value of the atom that only depends on the value, so it is the same in every execution. The numbers that are equal have the same hash whatever their types, except the numbers that are only equal after a conversion to a long or a boolean. The hash of the dicos doesn't depend on the order of the values. The hash of a vector, a dico or a buffer is cached in its payload and reset when the container is retrieved to be modified, so a container mustn't be hashed while a pointer to modify it is used.
+         @return The hash.
+         */
+        ulong getHash() const noexcept;
+        
+        //! Compare the atom with another strictly.
+        /** The function compares the types and the values of two atoms and of their children, unlike the comparison operator a long and a double are never identical. The containers that share their payload are identical without being compared.
+         @param lhs The atom.
+         @param rhs The other atom.
+         @return true if the atoms are identical, otherwise false.
+         */
+        static bool identical(Atom const& lhs, Atom const& rhs) noexcept;
+        
+        //! Retrieve the hash of a vector of atoms.
+        /** The function retrieves the hash of a vector of atoms, it is the hash of an atom that holds the vector.
+         @param atoms The vector of atoms.
+         @return The hash.
+         */
+        static ulong hash(Vector const& atoms) noexcept;
         
         //! Parse a string into a vector of atoms.
         /** Parse a string into a vector of atoms.
@@ -855,8 +1310,181 @@ namespace Kiwi
          @return    The vector of atoms.
          @remark    For example, the string : "foo \"bar 42\" 1 2 3.14" will parsed into a vector of 5 atoms.
          The atom types will be determined automatically as 2 #Atom::Type::TAG atoms, 2 #Atom::Type::LONG atoms, and 1 #Atom::Type::DOUBLE atom.
+         @remark    The memory of the atoms is allocated from the arena of the current thread if a scope is active.
+         @see Arena::Scope
+         */
+        static Vector parse(string_view text);
+        
+        //! Parse a string into a vector of atoms.
+        /** Parse a string into a vector of atoms, the vector is cleared first and its memory is reused so a caller that parses many strings can avoid the allocations.
+         @param     text	The string to parse.
+         @param     atoms   The vector of atoms.
+         @see parse
+         */
+        static void parse(string_view text, Vector& atoms);
+    };
+    
+    // ================================================================================ //
+    //                                      TOKENIZER                                   //
+    // ================================================================================ //
+    
+    //! The tokenizer parses a stream of messages received in chunks of any size.
+    /** The tokenizer splits a stream of characters into messages at the terminators and parses each message into a vector of atoms as Atom::parse does. The state between two chunks is kept so a word, a quoted word or an escape sequence can be split anywhere. A terminator inside a word or a quoted word must be preceded by a backslash, a quote that isn't closed before the end of its message is ignored. The vector given to the callback is reused for the next messages so the parsing of a stream doesn't allocate once the vector has grown.
+     @see Atom::parse
+     */
+    class Atom::Tokenizer
+    {
+    private:
+        enum State : unsigned char
+        {
+            BETWEEN = 0,
+            WORD    = 1,
+            QUOTED  = 2
+        };
+        
+        bool    m_terminators[256];
+        State   m_state;
+        bool    m_escape;
+        string  m_pending;
+        Vector  m_atoms;
+        
+        //! Parses the characters until the end of a message.
+        /** The function parses the characters and returns the position after the terminator of the message, or null if the characters have been consumed before the end of the message.
+         */
+        char const* scan(char const* it, char const* const end);
+        
+        //! Ends the current word at the end of the stream.
+        void close();
+        
+    public:
+        
+        //! Constructor.
+        /** Creates a tokenizer.
+         @param terminators The characters that end a message.
+         */
+        Tokenizer(string_view terminators = ";\n") noexcept;
+        
+        //! Destructor.
+        inline ~Tokenizer() noexcept {}
+        
+        //! Parses a chunk of the stream.
+        /** The function parses a chunk and calls the callback with the vector of atoms of each message ended in the chunk, the empty messages are skipped.
+         @param chunk    The characters.
+         @param callback The function called with a Vector const&.
+         */
+        template <class Callback> void write(string_view chunk, Callback&& callback)
+        {
+            char const* it = chunk.data();
+            char const* const end = it + chunk.size();
+            while((it = scan(it, end)))
+            {
+                if(!m_atoms.empty())
+                {
+                    callback(const_cast<Vector const&>(m_atoms));
+                    m_atoms.clear();
+                }
+            }
+        }
+        
+        //! Ends the stream.
+        /** The function ends the last message if it hasn't been terminated and calls the callback with its vector of atoms. The tokenizer can then parse a new stream.
+         @param callback The function called with a Vector const&.
+         */
+        template <class Callback> void flush(Callback&& callback)
+        {
+            close();
+            if(!m_atoms.empty())
+            {
+                callback(const_cast<Vector const&>(m_atoms));
+                m_atoms.clear();
+            }
+        }
+        
+        //! Discards the current message.
+        /** The function discards the words of the message that hasn't been terminated.
+         */
+        void reset() noexcept;
+    };
+    
+    // ================================================================================ //
+    //                                      HASH                                        //
+    // ================================================================================ //
+    
+    //! The hash function of the atoms.
+    /** The function object retrieves the hash of an atom or of a vector of atoms for the unordered containers. There is no specialization of std::hash because the comparison operator of the atoms converts the numbers, so it must be paired with Atom::Identical.
+     @see Atom::getHash
+     */
+    struct Atom::Hash
+    {
+        inline size_t operator()(Atom const& atom) const noexcept {return size_t(atom.getHash());}
+        inline size_t operator()(Vector const& atoms) const noexcept {return size_t(Atom::hash(atoms));}
+    };
+    
+    //! The equality function of the atoms.
+    /** The function object compares two atoms or two vectors of atoms strictly for the unordered containers that use Atom::Hash, the vectors are compared without being copied in atoms.
+     @see Atom::identical
+     */
+    struct Atom::Identical
+    {
+        inline bool operator()(Atom const& lhs, Atom const& rhs) const noexcept {return Atom::identical(lhs, rhs);}
+        inline bool operator()(Vector const& lhs, Vector const& rhs) const noexcept
+        {
+            return lhs.size() == rhs.size() && equal(lhs.begin(), lhs.end(), rhs.begin(), Atom::identical);
+        }
+    };
+    
+    // ================================================================================ //
+    //                                      POOL                                        //
+    // ================================================================================ //
+    
+    //! The pool shares the payloads of the identical containers.
+    /** The pool keeps an atom for each distinct vector, dico or buffer that is interned, an identical container interned later retrieves an atom that shares the payload of the first one, so the many identical constant messages of a patch only use the memory of one. The containers are compared by their types and their values, so a long and a double are never identical. The shared payloads remain immutable because an atom that modifies its container copies it first. The pool can be used by several threads.
+     @see Atom::getHash
+     */
+    class Atom::Pool
+    {
+    private:
+        unordered_set<Atom, Atom::Hash, Atom::Identical> m_atoms;
+        mutable mutex                           m_mutex;
+        
+    public:
+        
+        //! Constructor.
+        /** Creates an empty pool.
+         */
+        inline Pool() noexcept {}
+        
+        //! Destructor.
+        /** Releases the atoms of the pool.
+         */
+        inline ~Pool() noexcept {}
+        
+        Pool(Pool const&) = delete;
+        Pool& operator=(Pool const&) = delete;
+        
+        //! Interns an atom.
+        /** The function retrieves the atom of the pool that is identical to an atom, the atom is added to the pool if there is none. The atoms that aren't a vector, a dico or a buffer are returned as they are.
+         @param atom The atom.
+         @return An atom that shares the payload of the atom of the pool.
+         */
+        Atom intern(Atom const& atom);
+        
+        //! Retrieve the number of atoms of the pool.
+        /** The function retrieves the number of distinct containers of the pool.
+         @return The number of atoms.
+         */
+        size_t size() const noexcept;
+        
+        //! Removes the atoms that aren't used.
+        /** The function removes the atoms whose payloads are only used by the pool.
+         @return The number of atoms removed.
+         */
+        size_t purge() noexcept;
+        
+        //! Removes all the atoms.
+        /** The function removes all the atoms of the pool, the atoms already interned still share their payloads.
          */
-        static Vector parse(string const& text);
+        void clear() noexcept;
     };
     
     ostream& operator<<(ostream &output, const Atom &atom);
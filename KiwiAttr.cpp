@@ -25,6 +25,9 @@
 
 namespace Kiwi
 {
+    // The tuple attributes are compiled with the library because they rely on the conversions of the atoms
+    template class Attr::Typed<Tuple>;
+    
     // ================================================================================ //
     //                                 ATTRIBUTE MANAGER								//
     // ================================================================================ //
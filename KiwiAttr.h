@@ -25,6 +25,7 @@
 #define __DEF_KIWI_ATTR__
 
 #include "KiwiAtom.h"
+#include "KiwiTagMap.h"
 
 namespace Kiwi
 {
@@ -224,13 +225,13 @@ namespace Kiwi
         /** The function retrieves the attribute label.
          @return The attribute label.
          */
-        inline string getLabel() const noexcept {return m_label;}
+        inline string const& getLabel() const noexcept {return m_label;}
         
         //! Retrieve the attribute category.
         /** The function retrieves the attribute category.
          @return The attribute category.
          */
-        inline string getCategory() const noexcept {return m_category;}
+        inline string const& getCategory() const noexcept {return m_category;}
         
         //! Retrieve the attribute order.
         /** The function retrieves the attribute order.
@@ -355,7 +356,22 @@ namespace Kiwi
         /** The function sets the attribute value with an atom.
          @param atom The atom.
          */
-        void setValue(Atom const& atom) override {m_value = atom;}
+        void setValue(Atom const& atom) override
+        {
+            // The containers are copied from the atom without a temporary copy
+            if constexpr(is_same<T, Vector>::value)
+            {
+                m_value = atom.getVector();
+            }
+            else if constexpr(is_same<T, Dico>::value)
+            {
+                m_value = atom.getDico();
+            }
+            else
+            {
+                m_value = atom;
+            }
+        }
         
         //! Freezes or unfreezes the current value.
         /** Freezes or unfreezes the current value.
@@ -366,12 +382,12 @@ namespace Kiwi
         //! Resets the value to its default state.
         /** Resets the value to its default state.
          */
-        inline void resetDefault() override  {setValue(m_default);}
+        inline void resetDefault() override  {m_value = m_default;}
         
         //! Resets the attribute values to frozen values.
         /** Resets the attribute values to its frozen values.
          */
-        inline void resetFrozen() override  {setValue(m_freezed);}
+        inline void resetFrozen() override  {m_value = m_freezed;}
     };
     
     // ================================================================================ //
@@ -405,7 +421,7 @@ namespace Kiwi
     class Attr::Manager : public inheritable_enable_shared_from_this<Manager>
     {
     private:
-        map<sTag, sAttr>                m_attrs;
+        TagMap<sAttr>                   m_attrs;
         mutable mutex                   m_attrs_mutex;
         
         //! Retrieves an attribute.
@@ -627,6 +643,7 @@ namespace Kiwi
     typedef shared_ptr<Attr::Typed<long>>		sAttrLong;
     typedef shared_ptr<Attr::Typed<double>>     sAttrDouble;
     typedef shared_ptr<Attr::Typed<sTag>>       sAttrTag;
+    typedef shared_ptr<Attr::Typed<Tuple>>      sAttrTuple;
 }
 
 #endif
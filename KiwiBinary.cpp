@@ -0,0 +1,1041 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+
+#include "KiwiBinary.h"
+#include "KiwiJson.h"
+#include "KiwiPersistentMap.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      ENCODER                                     //
+    // ================================================================================ //
+    
+    //! The encoder appends the atoms to the data and collects the names of the tags.
+    class Binary::Encoder
+    {
+    private:
+        string&             m_data;
+        TagMap<uint32_t>    m_indices;
+        bool                m_valid;
+        
+        //! Writes the size of the content of a container in the place kept at a position.
+        inline void patchContent(const size_t pos) noexcept
+        {
+            const uint64_t size = m_data.size() - pos - 4;
+            if(size > UINT32_MAX)
+            {
+                m_valid = false;
+            }
+            patchFixed(pos, size, 4);
+        }
+        
+    public:
+        Encoder(string& data) noexcept : m_data(data), m_valid(true) {}
+        
+        //! Checks that the sizes of all the containers could be written.
+        inline bool isValid() const noexcept
+        {
+            return m_valid;
+        }
+        
+        inline void writeByte(const unsigned char value)
+        {
+            m_data += char(value);
+        }
+        
+        inline void writeVarint(uint64_t value)
+        {
+            while(value >= 0x80)
+            {
+                m_data += char((value & 0x7F) | 0x80);
+                value >>= 7;
+            }
+            m_data += char(value);
+        }
+        
+        inline void writeFixed(const uint64_t value, const size_t size)
+        {
+            for(size_t i = 0; i < size; i++)
+            {
+                m_data += char((value >> (i * 8)) & 0xFF);
+            }
+        }
+        
+        inline void patchFixed(const size_t pos, const uint64_t value, const size_t size) noexcept
+        {
+            for(size_t i = 0; i < size; i++)
+            {
+                m_data[pos + i] = char((value >> (i * 8)) & 0xFF);
+            }
+        }
+        
+        inline void writeNumber(const double value)
+        {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            writeFixed(bits, 8);
+        }
+        
+        inline void writeNumber(const float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            writeFixed(bits, 4);
+        }
+        
+        void writeTag(sTag const& tag)
+        {
+            auto it = m_indices.find(tag);
+            if(it == m_indices.end())
+            {
+                const uint32_t index = uint32_t(m_indices.size());
+                m_indices[tag] = index;
+                writeVarint(index);
+            }
+            else
+            {
+                writeVarint(it->second);
+            }
+        }
+        
+        void writeValue(Atom const& atom)
+        {
+            writeByte(atom.getType());
+            switch(atom.getType())
+            {
+                case Atom::BOOLEAN:
+                    writeByte(bool(atom) ? 1 : 0);
+                    break;
+                case Atom::LONG:
+                {
+                    // The zigzag encoding keeps the small negative values short, the long is widened so the shift is defined whatever its size
+                    const int64_t value = long(atom);
+                    writeVarint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+                    break;
+                }
+                case Atom::DOUBLE:
+                    writeNumber(double(atom));
+                    break;
+                case Atom::TAG:
+                    writeTag(sTag(atom));
+                    break;
+                case Atom::VECTOR:
+                {
+                    Vector const& vector = atom.getVector();
+                    const size_t pos = m_data.size();
+                    writeFixed(0, 4);
+                    writeVarint(vector.size());
+                    for(auto const& value : vector)
+                    {
+                        writeValue(value);
+                    }
+                    patchContent(pos);
+                    break;
+                }
+                case Atom::DICO:
+                {
+                    Dico const& dico = atom.getDico();
+                    const size_t pos = m_data.size();
+                    writeFixed(0, 4);
+                    writeVarint(dico.size());
+                    for(auto const& value : dico)
+                    {
+                        writeTag(value.first);
+                        writeValue(value.second);
+                    }
+                    patchContent(pos);
+                    break;
+                }
+                case Atom::DOUBLES:
+                    writeVarint(atom.getDoubles().size());
+                    for(double value : atom.getDoubles())
+                    {
+                        writeNumber(value);
+                    }
+                    break;
+                case Atom::FLOATS:
+                    writeVarint(atom.getFloats().size());
+                    for(float value : atom.getFloats())
+                    {
+                        writeNumber(value);
+                    }
+                    break;
+                case Atom::TUPLE:
+                {
+                    const Tuple tuple = atom;
+                    writeByte((unsigned char)tuple.size());
+                    for(float value : tuple)
+                    {
+                        writeNumber(value);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        
+        void writeValue(PersistentDico const& dico)
+        {
+            writeByte(Atom::DICO);
+            const size_t pos = m_data.size();
+            writeFixed(0, 4);
+            writeVarint(dico.size());
+            dico.forEach([this](sTag const& tag, Atom const& value)
+            {
+                writeTag(tag);
+                writeValue(value);
+            });
+            patchContent(pos);
+        }
+        
+        void writeTable()
+        {
+            writeVarint(m_indices.size());
+            for(auto const& it : m_indices)
+            {
+                string const& name = it.first->getName();
+                writeVarint(name.size());
+                m_data += name;
+            }
+        }
+    };
+    
+    // ================================================================================ //
+    //                                      DECODER                                     //
+    // ================================================================================ //
+    
+    //! The decoder reads the atoms from the data and checks its bounds.
+    class Binary::Decoder
+    {
+    private:
+        char const*                 m_it;
+        char const*                 m_end;
+        vector<sTag> const*         m_tags;
+        vector<string_view> const*  m_names;
+        
+    public:
+        //! Creates a decoder whose tags have been created.
+        Decoder(char const* first, char const* last, vector<sTag> const& tags) noexcept : m_it(first), m_end(last), m_tags(&tags), m_names(nullptr) {}
+        
+        //! Creates a decoder that creates the tags from their names when they are read.
+        Decoder(char const* first, char const* last, vector<string_view> const& names) noexcept : m_it(first), m_end(last), m_tags(nullptr), m_names(&names) {}
+        
+        inline char const* position() const noexcept
+        {
+            return m_it;
+        }
+        
+        inline void seek(char const* first, char const* last) noexcept
+        {
+            m_it  = first;
+            m_end = last;
+        }
+        
+        inline bool done() const noexcept
+        {
+            return m_it == m_end;
+        }
+        
+        inline bool readByte(unsigned char& value) noexcept
+        {
+            if(m_it == m_end)
+            {
+                return false;
+            }
+            value = (unsigned char)*m_it++;
+            return true;
+        }
+        
+        inline bool readVarint(uint64_t& value) noexcept
+        {
+            value = 0;
+            for(int shift = 0; shift < 64 && m_it != m_end; shift += 7)
+            {
+                const unsigned char byte = (unsigned char)*m_it++;
+                value |= uint64_t(byte & 0x7F) << shift;
+                if(!(byte & 0x80))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        inline bool readFixed(uint64_t& value, const size_t size) noexcept
+        {
+            if(size_t(m_end - m_it) < size)
+            {
+                return false;
+            }
+            value = 0;
+            for(size_t i = 0; i < size; i++)
+            {
+                value |= uint64_t((unsigned char)m_it[i]) << (i * 8);
+            }
+            m_it += size;
+            return true;
+        }
+        
+        inline bool readNumber(double& value) noexcept
+        {
+            uint64_t bits;
+            if(!readFixed(bits, 8))
+            {
+                return false;
+            }
+            memcpy(&value, &bits, sizeof(value));
+            return true;
+        }
+        
+        inline bool readNumber(float& value) noexcept
+        {
+            uint64_t bits;
+            if(!readFixed(bits, 4))
+            {
+                return false;
+            }
+            const uint32_t bits32 = uint32_t(bits);
+            memcpy(&value, &bits32, sizeof(value));
+            return true;
+        }
+        
+        //! Reads a number of values, a value can't be smaller than a byte.
+        inline bool readCount(uint64_t& count, const size_t size) noexcept
+        {
+            return readVarint(count) && count <= uint64_t(m_end - m_it) / size;
+        }
+        
+        bool readTable(vector<string_view>& names)
+        {
+            uint64_t count;
+            if(!readCount(count, 1))
+            {
+                return false;
+            }
+            names.reserve(size_t(count));
+            for(uint64_t i = 0; i < count; i++)
+            {
+                uint64_t size;
+                if(!readCount(size, 1))
+                {
+                    return false;
+                }
+                names.push_back(string_view(m_it, size_t(size)));
+                m_it += size;
+            }
+            return true;
+        }
+        
+        bool readTag(sTag& tag)
+        {
+            uint64_t index;
+            if(!readVarint(index))
+            {
+                return false;
+            }
+            if(m_tags)
+            {
+                if(index >= m_tags->size())
+                {
+                    return false;
+                }
+                tag = (*m_tags)[size_t(index)];
+            }
+            else
+            {
+                if(index >= m_names->size())
+                {
+                    return false;
+                }
+                tag = Tag::create((*m_names)[size_t(index)]);
+            }
+            return true;
+        }
+        
+        inline bool skip(const uint64_t size) noexcept
+        {
+            if(size > uint64_t(m_end - m_it))
+            {
+                return false;
+            }
+            m_it += size;
+            return true;
+        }
+        
+        //! Skips a value without decoding it.
+        bool skipValue() noexcept
+        {
+            unsigned char type;
+            uint64_t value;
+            if(!readByte(type))
+            {
+                return false;
+            }
+            switch(type)
+            {
+                case Atom::UNDEFINED:
+                    return true;
+                case Atom::BOOLEAN:
+                    return readByte(type);
+                case Atom::LONG:
+                case Atom::TAG:
+                    return readVarint(value);
+                case Atom::DOUBLE:
+                    return skip(8);
+                case Atom::VECTOR:
+                case Atom::DICO:
+                    return readFixed(value, 4) && skip(value);
+                case Atom::DOUBLES:
+                    return readCount(value, 8) && skip(value * 8);
+                case Atom::FLOATS:
+                    return readCount(value, 4) && skip(value * 4);
+                case Atom::TUPLE:
+                    return readByte(type) && type <= Tuple::capacity && skip(type * 4ul);
+                default:
+                    return false;
+            }
+        }
+        
+        //! Restricts the decoding to the content of a container.
+        bool readContent(char const*& end) noexcept
+        {
+            uint64_t size;
+            if(!readFixed(size, 4) || size > uint64_t(m_end - m_it))
+            {
+                return false;
+            }
+            end = m_end;
+            m_end = m_it + size;
+            return true;
+        }
+        
+        //! Reads the value of a type that isn't a container.
+        bool readScalar(const unsigned char type, Atom& atom)
+        {
+            switch(type)
+            {
+                case Atom::UNDEFINED:
+                    return true;
+                case Atom::BOOLEAN:
+                {
+                    unsigned char value;
+                    if(!readByte(value) || value > 1)
+                    {
+                        return false;
+                    }
+                    atom = bool(value);
+                    return true;
+                }
+                case Atom::LONG:
+                {
+                    uint64_t value;
+                    if(!readVarint(value))
+                    {
+                        return false;
+                    }
+                    atom = long(int64_t(value >> 1) ^ -int64_t(value & 1));
+                    return true;
+                }
+                case Atom::DOUBLE:
+                {
+                    double value;
+                    if(!readNumber(value))
+                    {
+                        return false;
+                    }
+                    atom = value;
+                    return true;
+                }
+                case Atom::TAG:
+                {
+                    sTag tag;
+                    if(!readTag(tag))
+                    {
+                        return false;
+                    }
+                    atom = tag;
+                    return true;
+                }
+                case Atom::DOUBLES:
+                {
+                    uint64_t count;
+                    if(!readCount(count, 8))
+                    {
+                        return false;
+                    }
+                    Doubles values((size_t)count);
+                    for(double& value : values)
+                    {
+                        readNumber(value);
+                    }
+                    atom = Atom(move(values));
+                    return true;
+                }
+                case Atom::FLOATS:
+                {
+                    uint64_t count;
+                    if(!readCount(count, 4))
+                    {
+                        return false;
+                    }
+                    Floats values((size_t)count);
+                    for(float& value : values)
+                    {
+                        readNumber(value);
+                    }
+                    atom = Atom(move(values));
+                    return true;
+                }
+                case Atom::TUPLE:
+                {
+                    unsigned char size;
+                    if(!readByte(size) || size > Tuple::capacity)
+                    {
+                        return false;
+                    }
+                    Tuple tuple;
+                    for(unsigned char i = 0; i < size; i++)
+                    {
+                        float value;
+                        if(!readNumber(value))
+                        {
+                            return false;
+                        }
+                        tuple.push_back(value);
+                    }
+                    atom = Atom(tuple);
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+        
+        //! Reads a value, the containers are tracked in a stack so the depth of the data doesn't use the stack of the thread, the depth is limited so the atoms can be freed and written recursively.
+        bool readValue(Atom& atom)
+        {
+            struct Frame
+            {
+                char const* end;
+                uint64_t    count;
+                bool        isdico;
+            };
+            
+            Json::Builder builder;
+            vector<Frame> frames;
+            for(;;)
+            {
+                if(frames.empty() || frames.back().count)
+                {
+                    unsigned char type;
+                    if(!frames.empty() && frames.back().isdico)
+                    {
+                        sTag key;
+                        if(!readTag(key))
+                        {
+                            return false;
+                        }
+                        builder.key(key);
+                    }
+                    if(!readByte(type))
+                    {
+                        return false;
+                    }
+                    if(type == Atom::VECTOR || type == Atom::DICO)
+                    {
+                        Frame frame;
+                        frame.isdico = type == Atom::DICO;
+                        if(frames.size() == max_depth || !readContent(frame.end) || !readCount(frame.count, frame.isdico ? 2 : 1))
+                        {
+                            return false;
+                        }
+                        frames.push_back(frame);
+                        frame.isdico ? builder.beginDico() : builder.beginVector();
+                        continue;
+                    }
+                    
+                    Atom value;
+                    if(!readScalar(type, value))
+                    {
+                        return false;
+                    }
+                    builder.value(move(value));
+                    if(frames.empty())
+                    {
+                        atom = move(builder.getAtom());
+                        return true;
+                    }
+                    frames.back().count--;
+                }
+                
+                // The containers whose values have been read are closed, their content must have been read entirely
+                while(!frames.back().count)
+                {
+                    if(!done())
+                    {
+                        return false;
+                    }
+                    m_end = frames.back().end;
+                    frames.back().isdico ? builder.endDico() : builder.endVector();
+                    frames.pop_back();
+                    if(frames.empty())
+                    {
+                        atom = move(builder.getAtom());
+                        return true;
+                    }
+                    frames.back().count--;
+                }
+            }
+        }
+    };
+    
+    // ================================================================================ //
+    //                                      BINARY                                      //
+    // ================================================================================ //
+    
+    template <class T> string Binary::encode(T const& value)
+    {
+        string data("KIWI", 4);
+        Encoder encoder(data);
+        encoder.writeByte(version);
+        encoder.writeFixed(0, 3);
+        encoder.writeFixed(0, 8);
+        encoder.writeValue(value);
+        encoder.patchFixed(8, data.size(), 8);
+        encoder.writeTable();
+        return encoder.isValid() ? data : string();
+    }
+    
+    string Binary::write(Atom const& atom)
+    {
+        return encode(atom);
+    }
+    
+    bool Binary::write(const int fd, Atom const& atom)
+    {
+        return writeData(fd, encode(atom));
+    }
+    
+    string Binary::write(PersistentDico const& dico)
+    {
+        return encode(dico);
+    }
+    
+    bool Binary::write(const int fd, PersistentDico const& dico)
+    {
+        return writeData(fd, encode(dico));
+    }
+    
+    bool Binary::writeData(const int fd, string const& data)
+    {
+        if(data.empty())
+        {
+            return false;
+        }
+        char const* it = data.data();
+        char const* const end = it + data.size();
+        while(it != end)
+        {
+#ifdef _WIN32
+            const long size = long(_write(fd, it, unsigned(end - it)));
+#else
+            const long size = long(::write(fd, it, size_t(end - it)));
+            if(size < 0 && errno == EINTR)
+            {
+                continue;
+            }
+#endif
+            if(size <= 0)
+            {
+                return false;
+            }
+            it += size;
+        }
+        return true;
+    }
+    
+    bool Binary::readHeader(string_view data, vector<string_view>& names, size_t& offset)
+    {
+        if(data.size() < header_size || data.compare(0, 4, "KIWI") || (unsigned char)data[4] != version)
+        {
+            return false;
+        }
+        Decoder decoder(data.data() + 8, data.data() + header_size, names);
+        uint64_t position;
+        decoder.readFixed(position, 8);
+        if(position < header_size || position > data.size())
+        {
+            return false;
+        }
+        offset = size_t(position);
+        decoder.seek(data.data() + offset, data.data() + data.size());
+        return decoder.readTable(names) && decoder.done();
+    }
+    
+    bool Binary::read(string_view data, Atom& atom)
+    {
+        // The table is read first so the tags are known when the atoms are read
+        vector<string_view> names;
+        size_t offset;
+        if(!readHeader(data, names, offset))
+        {
+            return false;
+        }
+        vector<sTag> tags;
+        tags.reserve(names.size());
+        for(auto const& name : names)
+        {
+            tags.push_back(Tag::create(name));
+        }
+        
+        Atom value;
+        Decoder decoder(data.data() + header_size, data.data() + offset, tags);
+        if(!decoder.readValue(value) || !decoder.done())
+        {
+            return false;
+        }
+        atom = move(value);
+        return true;
+    }
+    
+    bool Binary::read(const int fd, Atom& atom)
+    {
+        string data;
+        char buffer[65536];
+        for(;;)
+        {
+#ifdef _WIN32
+            const long size = long(_read(fd, buffer, unsigned(sizeof(buffer))));
+#else
+            const long size = long(::read(fd, buffer, sizeof(buffer)));
+            if(size < 0 && errno == EINTR)
+            {
+                continue;
+            }
+#endif
+            if(size < 0)
+            {
+                return false;
+            }
+            if(size == 0)
+            {
+                return read(string_view(data), atom);
+            }
+            data.append(buffer, size_t(size));
+        }
+    }
+    
+    // ================================================================================ //
+    //                                      FILE                                        //
+    // ================================================================================ //
+    
+    Binary::File::File(string const& path) :
+    m_data(nullptr),
+    m_size(0ul),
+    m_map(nullptr),
+    m_offset(0ul),
+    m_valid(false)
+    {
+#ifdef _WIN32
+        ifstream stream(path, ios::binary);
+        if(stream)
+        {
+            m_copy.assign(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+            m_data = m_copy.data();
+            m_size = m_copy.size();
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd >= 0)
+        {
+            struct stat info;
+            if(fstat(fd, &info) == 0 && info.st_size > 0)
+            {
+                void* map = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if(map != MAP_FAILED)
+                {
+                    m_map  = map;
+                    m_data = static_cast<char const*>(map);
+                    m_size = size_t(info.st_size);
+                }
+            }
+            ::close(fd);
+        }
+#endif
+        load();
+    }
+    
+    Binary::File::File(char const* data, const size_t size) :
+    m_data(data),
+    m_size(size),
+    m_map(nullptr),
+    m_offset(0ul),
+    m_valid(false)
+    {
+        load();
+    }
+    
+    Binary::File::~File() noexcept
+    {
+#ifndef _WIN32
+        if(m_map)
+        {
+            munmap(m_map, m_size);
+        }
+#endif
+    }
+    
+    void Binary::File::load()
+    {
+        if(!m_data)
+        {
+            return;
+        }
+        // Only the positions of the names are kept, the tags are created when the keys are read
+        m_valid = readHeader(string_view(m_data, m_size), m_names, m_offset);
+    }
+    
+    Binary::View Binary::File::getRoot() const noexcept
+    {
+        if(!m_valid)
+        {
+            return View();
+        }
+        return View(this, m_data + header_size, m_data + m_offset);
+    }
+    
+    // ================================================================================ //
+    //                                      VIEW                                        //
+    // ================================================================================ //
+    
+    Atom::Type Binary::View::getType() const noexcept
+    {
+        if(m_value == m_end || (unsigned char)*m_value > Atom::TUPLE)
+        {
+            return Atom::UNDEFINED;
+        }
+        return Atom::Type(*m_value);
+    }
+    
+    Atom Binary::View::getScalar() const
+    {
+        Atom atom;
+        const Atom::Type type = getType();
+        if(type == Atom::BOOLEAN || type == Atom::LONG || type == Atom::DOUBLE || type == Atom::TAG)
+        {
+            Decoder decoder(m_value + 1, m_end, m_file->m_names);
+            decoder.readScalar((unsigned char)type, atom);
+        }
+        return atom;
+    }
+    
+    bool Binary::View::getContent(char const*& first, char const*& last, uint64_t& size) const noexcept
+    {
+        Decoder decoder(m_value + 1, m_end, m_file->m_names);
+        uint64_t length;
+        if(!decoder.readFixed(length, 4) || length > uint64_t(m_end - decoder.position()))
+        {
+            return false;
+        }
+        last = decoder.position() + length;
+        decoder.seek(decoder.position(), last);
+        if(!decoder.readVarint(size))
+        {
+            return false;
+        }
+        first = decoder.position();
+        return true;
+    }
+    
+    size_t Binary::View::size() const noexcept
+    {
+        const Atom::Type type = getType();
+        uint64_t size = 0;
+        if(type == Atom::VECTOR || type == Atom::DICO)
+        {
+            char const* first;
+            char const* last;
+            if(!getContent(first, last, size))
+            {
+                return 0ul;
+            }
+        }
+        else if(type == Atom::DOUBLES || type == Atom::FLOATS)
+        {
+            Decoder decoder(m_value + 1, m_end, m_file->m_names);
+            if(!decoder.readVarint(size))
+            {
+                return 0ul;
+            }
+        }
+        else if(type == Atom::TUPLE && m_end - m_value > 1)
+        {
+            size = min(uint64_t((unsigned char)m_value[1]), uint64_t(Tuple::capacity));
+        }
+        return size_t(size);
+    }
+    
+    Binary::View Binary::View::operator[](const sTag& key) const noexcept
+    {
+        char const* first;
+        char const* last;
+        uint64_t size;
+        if(getType() != Atom::DICO || !getContent(first, last, size))
+        {
+            return View();
+        }
+        
+        // The entries are compared by the names of their keys without creating the tags and the other values are skipped
+        vector<string_view> const& names = m_file->m_names;
+        string_view name(key->getName());
+        Decoder decoder(first, last, names);
+        for(uint64_t i = 0; i < size; i++)
+        {
+            uint64_t index;
+            if(!decoder.readVarint(index))
+            {
+                break;
+            }
+            if(index < names.size() && names[size_t(index)] == name)
+            {
+                return View(m_file, decoder.position(), last);
+            }
+            if(!decoder.skipValue())
+            {
+                break;
+            }
+        }
+        return View();
+    }
+    
+    Binary::View Binary::View::operator[](const size_t index) const noexcept
+    {
+        char const* first;
+        char const* last;
+        uint64_t size;
+        if(getType() != Atom::VECTOR || !getContent(first, last, size) || index >= size)
+        {
+            return View();
+        }
+        Decoder decoder(first, last, m_file->m_names);
+        for(size_t i = 0; i < index; i++)
+        {
+            if(!decoder.skipValue())
+            {
+                return View();
+            }
+        }
+        return View(m_file, decoder.position(), last);
+    }
+    
+    Atom Binary::View::toAtom() const
+    {
+        Atom atom;
+        if(m_file)
+        {
+            Decoder decoder(m_value, m_end, m_file->m_names);
+            if(!decoder.readValue(atom))
+            {
+                return Atom();
+            }
+        }
+        return atom;
+    }
+    
+    Binary::View::iterator Binary::View::begin() const noexcept
+    {
+        char const* first;
+        char const* last;
+        uint64_t size;
+        const Atom::Type type = getType();
+        if((type != Atom::VECTOR && type != Atom::DICO) || !getContent(first, last, size))
+        {
+            return iterator(nullptr, nullptr, nullptr, false);
+        }
+        return iterator(m_file, first, last, type == Atom::DICO);
+    }
+    
+    Binary::View::iterator Binary::View::end() const noexcept
+    {
+        char const* first;
+        char const* last;
+        uint64_t size;
+        const Atom::Type type = getType();
+        if((type != Atom::VECTOR && type != Atom::DICO) || !getContent(first, last, size))
+        {
+            return iterator(nullptr, nullptr, nullptr, false);
+        }
+        return iterator(m_file, last, last, type == Atom::DICO);
+    }
+    
+    sTag Binary::View::iterator::getKey() const noexcept
+    {
+        Decoder decoder(m_it, m_end, m_file->m_names);
+        sTag key;
+        if(m_dico)
+        {
+            decoder.readTag(key);
+        }
+        return key;
+    }
+    
+    Binary::View Binary::View::iterator::operator*() const noexcept
+    {
+        Decoder decoder(m_it, m_end, m_file->m_names);
+        uint64_t index;
+        if(m_dico && !decoder.readVarint(index))
+        {
+            return View();
+        }
+        return View(m_file, decoder.position(), m_end);
+    }
+    
+    Binary::View::iterator& Binary::View::iterator::operator++() noexcept
+    {
+        Decoder decoder(m_it, m_end, m_file->m_names);
+        uint64_t index;
+        if((m_dico && !decoder.readVarint(index)) || !decoder.skipValue())
+        {
+            // The invalid data ends the iteration
+            m_it = m_end;
+        }
+        else
+        {
+            m_it = decoder.position();
+        }
+        return *this;
+    }
+}
@@ -0,0 +1,304 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_BINARY__
+#define __DEF_KIWI_BINARY__
+
+#include "KiwiAtom.h"
+#include "KiwiTagMap.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      BINARY                                      //
+    // ================================================================================ //
+    
+    //! The binary reads and writes the atoms in a compact binary format.
+    /** The binary format starts with a header of 16 bytes : the characters "KIWI", the version of the format, three reserved bytes and the offset of the table of the tags on 8 bytes. The root atom follows the header, each atom is a byte of its type followed by its value :
+     - the undefined atoms have no value, the booleans are a byte.
+     - the longs are zigzag varints and the doubles are the 8 bytes of the IEEE representation.
+     - the tags are the varint indices of their names in the table.
+     - the vectors and the dicos are the size in bytes of their content on 4 bytes followed by the varint number of values and the values, each value of a dico is preceded by the index of its tag, so a reader can skip them.
+     - the buffers are the varint number of values followed by the values, the tuples are a byte of their size followed by this number of floats.
+     The table is the varint number of tags followed by the varint size and the characters of each name. All the numbers are little-endian.
+     @see Json
+     */
+    class Binary
+    {
+    private:
+        class Encoder;
+        class Decoder;
+        
+        //! Checks the header of the data, reads the names of the table of the tags and retrieves the offset of the table.
+        static bool readHeader(string_view data, vector<string_view>& names, size_t& offset);
+        
+        //! Encodes an atom or a persistent dico with the header and the table of the tags.
+        template <class T> static string encode(T const& value);
+        
+        //! Writes the data to a file descriptor, the empty data of an encoding that failed isn't written.
+        static bool writeData(const int fd, string const& data);
+        
+    public:
+        class File;
+        class View;
+        
+        //! The version of the format.
+        static const unsigned char version = 1;
+        
+        //! The size of the header.
+        static const size_t header_size = 16ul;
+        
+        //! The maximum depth of the containers that can be read.
+        static const size_t max_depth = 1024ul;
+        
+        //! Writes an atom.
+        /** The function encodes an atom in the binary format.
+         @param atom The atom.
+         @return The data, or an empty string if the content of a container exceeds the 4 bytes of its size.
+         */
+        static string write(Atom const& atom);
+        
+        //! Writes an atom.
+        /** The function encodes an atom in the binary format and writes it to a file descriptor.
+         @param fd   The file descriptor.
+         @param atom The atom.
+         @return true if the data has been written, otherwise false, also if the content of a container exceeds the 4 bytes of its size.
+         */
+        static bool write(const int fd, Atom const& atom);
+        
+        //! Writes a persistent dico.
+        /** The function encodes a persistent dico in the binary format as a dico, without copying it in a dico, so it is read as a dico.
+         @param dico The persistent dico.
+         @return The data, or an empty string if the content of a container exceeds the 4 bytes of its size.
+         */
+        static string write(PersistentDico const& dico);
+        
+        //! Writes a persistent dico.
+        /** The function encodes a persistent dico in the binary format as a dico and writes it to a file descriptor.
+         @param fd   The file descriptor.
+         @param dico The persistent dico.
+         @return true if the data has been written, otherwise false, also if the content of a container exceeds the 4 bytes of its size.
+         */
+        static bool write(const int fd, PersistentDico const& dico);
+        
+        //! Reads an atom.
+        /** The function decodes an atom from the binary format.
+         @param data The data.
+         @param atom The atom.
+         @return true if the data is valid, otherwise false and the atom is unchanged. The data is invalid if its containers are nested deeper than max_depth.
+         */
+        static bool read(string_view data, Atom& atom);
+        
+        //! Reads an atom.
+        /** The function reads the data of a file descriptor until the end of the file and decodes an atom.
+         @param fd   The file descriptor.
+         @param atom The atom.
+         @return true if the data is valid, otherwise false and the atom is unchanged.
+         */
+        static bool read(const int fd, Atom& atom);
+    };
+    
+    // ================================================================================ //
+    //                                      FILE                                        //
+    // ================================================================================ //
+    
+    //! The file gives a read-only access to the data of the binary format without decoding it.
+    /** The file maps the data in memory and only reads the header and finds the names of the table of the tags when it is opened. The tags are created when the keys are read, so the names that aren't accessed don't enter the pool of the tags. The atoms are accessed through views that decode the values on demand. The file is mapped on the POSIX systems and read in memory on the others.
+     @see Binary::View
+     */
+    class Binary::File
+    {
+    private:
+        friend class Binary::View;
+        
+        char const*         m_data;
+        size_t              m_size;
+        void*               m_map;
+        string              m_copy;
+        vector<string_view> m_names;
+        size_t              m_offset;
+        bool                m_valid;
+        
+        //! Checks the data and finds the names of the tags.
+        void load();
+        
+        //! Constructor.
+        /** Opens data in memory, the constructor is private and takes a pointer and a size so a string of data can't be taken for a path.
+         @see fromMemory
+         */
+        File(char const* data, const size_t size);
+        
+    public:
+        
+        //! Constructor.
+        /** Opens a file.
+         @param path The path of the file.
+         */
+        explicit File(string const& path);
+        
+        //! Opens data in memory.
+        /** The function opens data in memory, for example the data returned by Binary::write. The data isn't copied so it must remain valid while the file and its views are used.
+         @param data The data.
+         @return The file.
+         */
+        static inline File fromMemory(string_view data) {return File(data.data(), data.size());}
+        
+        //! Destructor.
+        /** Unmaps the file, the views of the file can't be used anymore.
+         */
+        ~File() noexcept;
+        
+        File(File const&) = delete;
+        File& operator=(File const&) = delete;
+        
+        //! Checks if the file is valid.
+        /** The function checks if the file has been opened and if its header and its table of tags are valid.
+         @return true if the file is valid, otherwise false.
+         */
+        inline bool isValid() const noexcept {return m_valid;}
+        
+        //! Retrieve the size of the file.
+        /** The function retrieves the number of bytes of the data.
+         @return The size.
+         */
+        inline size_t getSize() const noexcept {return m_size;}
+        
+        //! Retrieve the root atom.
+        /** The function retrieves a view of the root atom.
+         @return The view or an undefined view if the file isn't valid.
+         */
+        View getRoot() const noexcept;
+    };
+    
+    // ================================================================================ //
+    //                                      VIEW                                        //
+    // ================================================================================ //
+    
+    //! The view is a read-only access to an atom of a file that decodes it on demand.
+    /** The view is a pointer to the data of an atom, it retrieves the type, the values and the children of the atom without decoding the rest of the data. The lookup of a key in a dico and of an index in a vector skip the values that precede it without decoding them. A view is undefined if the atom doesn't exist or if the data is invalid, and it is valid while its file exists.
+     @see Binary::File
+     */
+    class Binary::View
+    {
+    private:
+        friend class Binary::File;
+        
+        File const* m_file;
+        char const* m_value;
+        char const* m_end;
+        
+        inline View(File const* file, char const* value, char const* end) noexcept : m_file(file), m_value(value), m_end(end) {}
+        
+        //! Retrieves the content of a vector or a dico.
+        bool getContent(char const*& first, char const*& last, uint64_t& size) const noexcept;
+        
+        //! Decodes a boolean, a number or a tag.
+        Atom getScalar() const;
+        
+    public:
+        
+        //! Constructor.
+        /** Creates an undefined view.
+         */
+        inline View() noexcept : m_file(nullptr), m_value(nullptr), m_end(nullptr) {}
+        
+        //! Retrieve the type of the atom.
+        /** The function retrieves the type of the atom.
+         @return The type or undefined if the view is undefined.
+         */
+        Atom::Type getType() const noexcept;
+        
+        inline bool isUndefined() const noexcept {return getType() == Atom::UNDEFINED;}
+        inline bool isBool() const noexcept {return getType() == Atom::BOOLEAN;}
+        inline bool isLong() const noexcept {return getType() == Atom::LONG;}
+        inline bool isDouble() const noexcept {return getType() == Atom::DOUBLE;}
+        inline bool isNumber() const noexcept {return isBool() || isLong() || isDouble();}
+        inline bool isTag() const noexcept {return getType() == Atom::TAG;}
+        inline bool isVector() const noexcept {return getType() == Atom::VECTOR;}
+        inline bool isDico() const noexcept {return getType() == Atom::DICO;}
+        inline bool isDoubles() const noexcept {return getType() == Atom::DOUBLES;}
+        inline bool isFloats() const noexcept {return getType() == Atom::FLOATS;}
+        inline bool isTuple() const noexcept {return getType() == Atom::TUPLE;}
+        
+        inline operator bool() const noexcept {return bool(getScalar());}
+        inline operator long() const noexcept {return long(getScalar());}
+        inline operator double() const noexcept {return double(getScalar());}
+        inline operator sTag() const noexcept {return sTag(getScalar());}
+        
+        //! Retrieve the size of the atom.
+        /** The function retrieves the number of values of a vector, a dico, a buffer or a tuple.
+         @return The number of values or 0 for the other types.
+         */
+        size_t size() const noexcept;
+        
+        //! Retrieve a value of a dico.
+        /** The function retrieves the value of a key of a dico.
+         @param key The key.
+         @return The view of the value or an undefined view if the atom isn't a dico or if the key isn't in the dico.
+         */
+        View operator[](const sTag& key) const noexcept;
+        
+        //! Retrieve a value of a vector.
+        /** The function retrieves a value of a vector.
+         @param index The index of the value.
+         @return The view of the value or an undefined view if the atom isn't a vector or if the index is out of range.
+         */
+        View operator[](const size_t index) const noexcept;
+        
+        //! Decodes the atom.
+        /** The function decodes the atom and all its values.
+         @return The atom or an undefined atom if the data is invalid.
+         */
+        Atom toAtom() const;
+        
+        //! The iterator walks through the values of a vector or a dico.
+        class iterator
+        {
+        private:
+            File const* m_file;
+            char const* m_it;
+            char const* m_end;
+            bool        m_dico;
+        public:
+            inline iterator(File const* file, char const* it, char const* end, const bool dico) noexcept : m_file(file), m_it(it), m_end(end), m_dico(dico) {}
+            
+            //! Retrieve the key of the value of a dico, a null tag for a vector.
+            sTag getKey() const noexcept;
+            
+            //! Retrieve the view of the value.
+            View operator*() const noexcept;
+            
+            iterator& operator++() noexcept;
+            inline bool operator==(iterator const& other) const noexcept {return m_it == other.m_it;}
+            inline bool operator!=(iterator const& other) const noexcept {return m_it != other.m_it;}
+        };
+        
+        //! Retrieve an iterator to the first value of a vector or a dico.
+        iterator begin() const noexcept;
+        
+        //! Retrieve an iterator to the end of a vector or a dico.
+        iterator end() const noexcept;
+    };
+}
+
+#endif
@@ -25,7 +25,13 @@
 #define __DEF_KIWI_CORE__
 
 #include "KiwiTag.h"
+#include "KiwiTagMap.h"
+#include "KiwiArena.h"
 #include "KiwiAtom.h"
+#include "KiwiJson.h"
+#include "KiwiBinary.h"
+#include "KiwiDiff.h"
+#include "KiwiPersistentMap.h"
 #include "KiwiBeacon.h"
 #include "KiwiClock.h"
 #include "KiwiAttr.h"
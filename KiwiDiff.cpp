@@ -0,0 +1,217 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+
+#include "KiwiDiff.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      DIFF                                        //
+    // ================================================================================ //
+    
+    //! Adds the operations that change an atom into another.
+    static void compare(Atom const& from, Atom const& to, Vector& path, Vector& operations)
+    {
+        if(from.isDico() && to.isDico())
+        {
+            Dico const& lhs = from.getDico();
+            Dico const& rhs = to.getDico();
+            if(&lhs == &rhs)
+            {
+                return;
+            }
+            for(auto const& entry : lhs)
+            {
+                if(!rhs.count(entry.first))
+                {
+                    path.push_back(Atom(entry.first));
+                    operations.push_back(Atom({Atom(KIWI_TAG("remove")), Atom(path)}));
+                    path.pop_back();
+                }
+            }
+            for(auto const& entry : rhs)
+            {
+                path.push_back(Atom(entry.first));
+                auto it = lhs.find(entry.first);
+                if(it == lhs.end())
+                {
+                    operations.push_back(Atom({Atom(KIWI_TAG("set")), Atom(path), entry.second}));
+                }
+                else
+                {
+                    compare(it->second, entry.second, path, operations);
+                }
+                path.pop_back();
+            }
+        }
+        else if(from.isVector() && to.isVector())
+        {
+            Vector const& lhs = from.getVector();
+            Vector const& rhs = to.getVector();
+            if(&lhs == &rhs)
+            {
+                return;
+            }
+            
+            // The values that are identical at the start and at the end are skipped
+            Vector::size_type first = 0, lend = lhs.size(), rend = rhs.size();
+            while(first < lend && first < rend && Atom::identical(lhs[first], rhs[first]))
+            {
+                first++;
+            }
+            while(lend > first && rend > first && Atom::identical(lhs[lend - 1], rhs[rend - 1]))
+            {
+                lend--;
+                rend--;
+            }
+            
+            // The values that remain are compared one by one if their number hasn't changed, otherwise they are replaced
+            if(lend - first == rend - first)
+            {
+                for(Vector::size_type i = first; i < lend; i++)
+                {
+                    path.push_back(Atom(long(i)));
+                    compare(lhs[i], rhs[i], path, operations);
+                    path.pop_back();
+                }
+            }
+            else
+            {
+                Vector values(rhs.begin() + first, rhs.begin() + rend);
+                operations.push_back(Atom({Atom(KIWI_TAG("splice")), Atom(path), Atom(long(first)), Atom(long(lend - first)), Atom(move(values))}));
+            }
+        }
+        else if(!Atom::identical(from, to))
+        {
+            operations.push_back(Atom({Atom(KIWI_TAG("set")), Atom(path), to}));
+        }
+    }
+    
+    Vector Diff::compute(Atom const& from, Atom const& to)
+    {
+        Vector operations, path;
+        compare(from, to, path, operations);
+        return operations;
+    }
+    
+    //! Retrieves an atom to modify it with the first steps of a path.
+    static Atom* find(Atom& atom, Vector const& path, const Vector::size_type size)
+    {
+        Atom* node = &atom;
+        for(Vector::size_type i = 0; i < size; i++)
+        {
+            Atom const& step = path[i];
+            if(step.isTag())
+            {
+                Dico* dico = node->editDico();
+                auto it = dico ? dico->find(sTag(step)) : Dico::iterator();
+                if(!dico || it == dico->end())
+                {
+                    return nullptr;
+                }
+                node = &it->second;
+            }
+            else if(step.isLong())
+            {
+                Vector* vector = node->editVector();
+                const long index = long(step);
+                if(!vector || index < 0 || Vector::size_type(index) >= vector->size())
+                {
+                    return nullptr;
+                }
+                node = &(*vector)[Vector::size_type(index)];
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+        return node;
+    }
+    
+    bool Diff::apply(Atom& atom, Vector const& operations)
+    {
+        for(auto const& operation : operations)
+        {
+            Vector const& values = operation.getVector();
+            if(values.size() < 2 || !values[0].isTag() || !values[1].isVector())
+            {
+                return false;
+            }
+            const sTag name = values[0];
+            Vector const& path = values[1].getVector();
+            
+            if(name == KIWI_TAG("set") && values.size() == 3)
+            {
+                if(path.empty())
+                {
+                    atom = values[2];
+                    continue;
+                }
+                Atom* parent = find(atom, path, path.size() - 1);
+                Atom const& last = path.back();
+                if(parent && last.isTag() && parent->isDico())
+                {
+                    parent->editDico()->insert_or_assign(sTag(last), values[2]);
+                }
+                else if(parent && last.isLong() && parent->isVector() && long(last) >= 0 && Vector::size_type(long(last)) < parent->getVector().size())
+                {
+                    (*parent->editVector())[Vector::size_type(long(last))] = values[2];
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            else if(name == KIWI_TAG("remove") && values.size() == 2 && !path.empty() && path.back().isTag())
+            {
+                Atom* parent = find(atom, path, path.size() - 1);
+                if(!parent || !parent->isDico() || !parent->editDico()->erase(sTag(path.back())))
+                {
+                    return false;
+                }
+            }
+            else if(name == KIWI_TAG("splice") && values.size() == 5 && values[2].isLong() && values[3].isLong() && values[4].isVector())
+            {
+                Atom* node = find(atom, path, path.size());
+                Vector* vector = node ? node->editVector() : nullptr;
+                const long index = long(values[2]);
+                const long count = long(values[3]);
+                if(!vector || index < 0 || count < 0 || Vector::size_type(index) > vector->size() || Vector::size_type(count) > vector->size() - Vector::size_type(index))
+                {
+                    return false;
+                }
+                Vector const& inserted = values[4].getVector();
+                auto it = vector->erase(vector->begin() + index, vector->begin() + index + count);
+                vector->insert(it, inserted.begin(), inserted.end());
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
@@ -0,0 +1,65 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_DIFF__
+#define __DEF_KIWI_DIFF__
+
+#include "KiwiAtom.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      DIFF                                        //
+    // ================================================================================ //
+    
+    //! The diff computes the differences between two atoms and applies them.
+    /** The differences are a vector of operations, each operation is a vector that starts with its name and the path of the atom it modifies. The path is a vector of the keys of the dicos and of the indices of the vectors from the root atom :
+     - [set, path, value] replaces the atom, or adds the key to its dico.
+     - [remove, path] removes the key from its dico.
+     - [splice, path, index, count, values] replaces a number of values of a vector from an index by a vector of values.
+     The differences are atoms so they can be stored and transferred as JSON or in the binary format. The containers that share their payload are skipped without being compared, so the differences between two versions of a tree that has been modified through copies on write are computed in a time proportional to the changes.
+     @see Atom::identical
+     */
+    class Diff
+    {
+    public:
+        
+        //! Computes the differences between two atoms.
+        /** The function computes the operations that change an atom into another.
+         @param from The atom.
+         @param to   The other atom.
+         @return The operations, empty if the atoms are identical.
+         */
+        static Vector compute(Atom const& from, Atom const& to);
+        
+        //! Applies differences.
+        /** The function applies the operations to an atom in place, the containers that are shared with other atoms are copied on the path of the operations only.
+         @param atom       The atom.
+         @param operations The operations.
+         @return true if all the operations have been applied, false if an operation is invalid, the operations that precede it remain applied.
+         */
+        static bool apply(Atom& atom, Vector const& operations);
+    };
+}
+
+#endif
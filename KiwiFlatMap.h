@@ -0,0 +1,451 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_FLATMAP__
+#define __DEF_KIWI_FLATMAP__
+
+#include "KiwiArena.h"
+#include "KiwiTag.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      FLAT MAP                                    //
+    // ================================================================================ //
+    
+    //! The flat map is an associative container indexed by tags and stored in a contiguous array.
+    /** The flat map has the interface of a map but the values are stored in a contiguous array in the order of insertion, except after an erasure that moves the last value at the position of the erased one. The small maps are searched linearly, the larger ones use an open-addressed index of the hashes of the tags, the tags are compared by identity and can't be modified through the iterators. The memory is allocated from the arena of the current thread if any. The tags must be valid.
+     @see Dico
+     */
+    template <class T> class FlatMap
+    {
+    public:
+        typedef sTag                                            key_type;
+        typedef T                                               mapped_type;
+        typedef pair<const sTag, T>                             value_type;
+    
+    private:
+        typedef pair<sTag, T>                                   Entry;
+        typedef vector<Entry, ArenaAllocator<Entry>>            Values;
+        typedef vector<uint32_t, ArenaAllocator<uint32_t>>      Slots;
+        
+        //! The iterator gives access to the entries with constant tags, so a tag can't be replaced without updating the index.
+        template <class V, class It> class Iterator
+        {
+        private:
+            friend class FlatMap;
+            template <class, class> friend class Iterator;
+            
+            It m_it;
+            
+            inline Iterator(It it) noexcept : m_it(it) {}
+            
+        public:
+            typedef random_access_iterator_tag   iterator_category;
+            typedef typename FlatMap::value_type value_type;
+            typedef ptrdiff_t                    difference_type;
+            typedef V*                           pointer;
+            typedef V&                           reference;
+            
+            inline Iterator() noexcept : m_it() {}
+            
+            //! Converts an iterator to a constant iterator.
+            template <class V2, class It2, class = typename enable_if<is_convertible<V2*, V*>::value>::type> inline Iterator(Iterator<V2, It2> const& other) noexcept : m_it(other.m_it) {}
+            
+            inline reference operator*() const noexcept
+            {
+                static_assert(sizeof(Entry) == sizeof(value_type) && alignof(Entry) == alignof(value_type), "The entries must have the layout of the values");
+                return reinterpret_cast<reference>(*m_it);
+            }
+            inline pointer operator->() const noexcept {return &(**this);}
+            inline reference operator[](const difference_type n) const noexcept {return *(*this + n);}
+            
+            inline Iterator& operator++() noexcept {++m_it; return *this;}
+            inline Iterator& operator--() noexcept {--m_it; return *this;}
+            inline Iterator operator++(int) noexcept {return Iterator(m_it++);}
+            inline Iterator operator--(int) noexcept {return Iterator(m_it--);}
+            inline Iterator& operator+=(const difference_type n) noexcept {m_it += n; return *this;}
+            inline Iterator& operator-=(const difference_type n) noexcept {m_it -= n; return *this;}
+            inline Iterator operator+(const difference_type n) const noexcept {return Iterator(m_it + n);}
+            inline Iterator operator-(const difference_type n) const noexcept {return Iterator(m_it - n);}
+            inline difference_type operator-(Iterator const& other) const noexcept {return m_it - other.m_it;}
+            
+            inline bool operator==(Iterator const& other) const noexcept {return m_it == other.m_it;}
+            inline bool operator!=(Iterator const& other) const noexcept {return m_it != other.m_it;}
+            inline bool operator<(Iterator const& other) const noexcept {return m_it < other.m_it;}
+        };
+        
+    public:
+        typedef typename Values::size_type                                      size_type;
+        typedef Iterator<value_type, typename Values::iterator>                 iterator;
+        typedef Iterator<value_type const, typename Values::const_iterator>     const_iterator;
+    
+    private:
+        static const size_type linear_size = 8;
+        
+        Values  m_values;
+        Slots   m_slots;
+        
+        //! Retrieves the first slot of a tag in the index.
+        static inline size_type home(const sTag& tag, const size_type mask) noexcept
+        {
+            const ulong hash = tag->getHash();
+            return size_type(hash ^ (hash >> 32)) & mask;
+        }
+        
+        //! Retrieves the position of a tag in the array, the size of the array if the tag isn't in the map.
+        size_type index(const sTag& tag) const noexcept
+        {
+            if(m_slots.empty())
+            {
+                for(size_type i = 0; i < m_values.size(); i++)
+                {
+                    if(m_values[i].first == tag)
+                    {
+                        return i;
+                    }
+                }
+                return m_values.size();
+            }
+            const size_type mask = m_slots.size() - 1;
+            for(size_type i = home(tag, mask);; i = (i + 1) & mask)
+            {
+                const uint32_t slot = m_slots[i];
+                if(!slot)
+                {
+                    return m_values.size();
+                }
+                if(m_values[slot - 1u].first == tag)
+                {
+                    return slot - 1u;
+                }
+            }
+        }
+        
+        //! Retrieves the slot of the index that refers to a position of the array.
+        size_type slot(const size_type pos) const noexcept
+        {
+            const size_type mask = m_slots.size() - 1;
+            size_type i = home(m_values[pos].first, mask);
+            while(m_slots[i] != pos + 1u)
+            {
+                i = (i + 1) & mask;
+            }
+            return i;
+        }
+        
+        //! Adds a position of the array to the index.
+        void place(const size_type pos) noexcept
+        {
+            const size_type mask = m_slots.size() - 1;
+            size_type i = home(m_values[pos].first, mask);
+            while(m_slots[i])
+            {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = uint32_t(pos + 1u);
+        }
+        
+        //! Rebuilds the index for a number of values, the index is removed if the values can be searched linearly.
+        void rehash(const size_type count)
+        {
+            if(count <= linear_size)
+            {
+                m_slots.clear();
+                return;
+            }
+            size_type size = 16;
+            while(size < count * 2)
+            {
+                size *= 2;
+            }
+            m_slots.assign(size, 0u);
+            for(size_type i = 0; i < m_values.size(); i++)
+            {
+                place(i);
+            }
+        }
+        
+        //! Appends a value that isn't in the map.
+        template <class ...Args> iterator append(Args&& ...args)
+        {
+            m_values.emplace_back(forward<Args>(args)...);
+            if(m_slots.empty() ? m_values.size() > linear_size : m_values.size() * 2 > m_slots.size())
+            {
+                rehash(m_values.size());
+            }
+            else if(!m_slots.empty())
+            {
+                place(m_values.size() - 1);
+            }
+            return iterator(m_values.end() - 1);
+        }
+    
+    public:
+        
+        //! Constructor.
+        /** Creates an empty map.
+         */
+        inline FlatMap() noexcept {}
+        
+        //! Constructor.
+        /** Creates a map with a list of values, the first value of a tag is kept.
+         */
+        FlatMap(initializer_list<pair<const sTag, T>> il)
+        {
+            reserve(il.size());
+            insert(il.begin(), il.end());
+        }
+        
+        //! Constructor.
+        /** Creates a map with a range of values, the first value of a tag is kept.
+         */
+        template <class InputIt> FlatMap(InputIt first, InputIt last)
+        {
+            insert(first, last);
+        }
+        
+        inline FlatMap(FlatMap const& other) = default;
+        inline FlatMap(FlatMap&& other) noexcept = default;
+        inline FlatMap& operator=(FlatMap const& other) = default;
+        inline FlatMap& operator=(FlatMap&& other) noexcept = default;
+        
+        //! Destructor.
+        /** Frees the values.
+         */
+        inline ~FlatMap() noexcept {}
+        
+        //! Swaps the values with another map.
+        inline void swap(FlatMap& other) noexcept
+        {
+            m_values.swap(other.m_values);
+            m_slots.swap(other.m_slots);
+        }
+        
+        inline iterator begin() noexcept {return iterator(m_values.begin());}
+        inline iterator end() noexcept {return iterator(m_values.end());}
+        inline const_iterator begin() const noexcept {return const_iterator(m_values.begin());}
+        inline const_iterator end() const noexcept {return const_iterator(m_values.end());}
+        inline const_iterator cbegin() const noexcept {return const_iterator(m_values.begin());}
+        inline const_iterator cend() const noexcept {return const_iterator(m_values.end());}
+        inline size_type size() const noexcept {return m_values.size();}
+        inline bool empty() const noexcept {return m_values.empty();}
+        
+        //! Reserves the memory for a number of values.
+        void reserve(const size_type count)
+        {
+            m_values.reserve(count);
+            if(count > linear_size && m_slots.size() < count * 2)
+            {
+                rehash(count);
+            }
+        }
+        
+        //! Retrieves a value.
+        /** The function retrieves the value of a tag.
+         @param tag The tag.
+         @return An iterator to the value or the end if the tag isn't in the map.
+         */
+        inline iterator find(const sTag& tag) noexcept
+        {
+            return iterator(m_values.begin() + index(tag));
+        }
+        
+        //! Retrieves a value.
+        /** The function retrieves the value of a tag.
+         @param tag The tag.
+         @return An iterator to the value or the end if the tag isn't in the map.
+         */
+        inline const_iterator find(const sTag& tag) const noexcept
+        {
+            return const_iterator(m_values.begin() + index(tag));
+        }
+        
+        //! Checks if a tag is in the map.
+        /** The function checks if a tag is in the map.
+         @param tag The tag.
+         @return 1 if the tag is in the map, otherwise 0.
+         */
+        inline size_type count(const sTag& tag) const noexcept
+        {
+            return index(tag) != m_values.size() ? 1 : 0;
+        }
+        
+        //! Retrieves or creates a value.
+        /** The function retrieves the value of a tag, if the tag isn't in the map a default value is inserted.
+         @param tag The tag.
+         @return The value.
+         */
+        T& operator[](const sTag& tag)
+        {
+            const size_type i = index(tag);
+            if(i != m_values.size())
+            {
+                return m_values[i].second;
+            }
+            return append(tag, T())->second;
+        }
+        
+        //! Inserts a value.
+        /** The function inserts a value if its tag isn't in the map.
+         @param value The tag and the value.
+         @return An iterator to the value of the tag and true if the value has been inserted.
+         */
+        template <class ...Args> pair<iterator, bool> emplace(const sTag& tag, Args&& ...args)
+        {
+            const size_type i = index(tag);
+            if(i != m_values.size())
+            {
+                return make_pair(iterator(m_values.begin() + i), false);
+            }
+            return make_pair(append(piecewise_construct, forward_as_tuple(tag), forward_as_tuple(forward<Args>(args)...)), true);
+        }
+        
+        //! Inserts a value.
+        /** The function inserts a value if its tag isn't in the map.
+         @param value The tag and the value.
+         @return An iterator to the value of the tag and true if the value has been inserted.
+         */
+        template <class P> inline pair<iterator, bool> insert(P&& value)
+        {
+            return emplace(value.first, forward<P>(value).second);
+        }
+        
+        //! Inserts a range of values.
+        /** The function inserts the values whose tags aren't in the map.
+         */
+        template <class InputIt> void insert(InputIt first, InputIt last)
+        {
+            for(; first != last; ++first)
+            {
+                emplace(first->first, first->second);
+            }
+        }
+        
+        //! Inserts or replaces a value.
+        /** The function inserts a value or replaces the value of the tag.
+         @param tag The tag.
+         @param value The value.
+         @return An iterator to the value of the tag and true if the value has been inserted.
+         */
+        template <class V> pair<iterator, bool> insert_or_assign(const sTag& tag, V&& value)
+        {
+            pair<iterator, bool> result = emplace(tag, forward<V>(value));
+            if(!result.second)
+            {
+                result.first->second = forward<V>(value);
+            }
+            return result;
+        }
+        
+        //! Removes a value.
+        /** The function removes the value at a position, the last value is moved to this position.
+         @param pos The position.
+         @return An iterator to the value moved at this position or the end.
+         */
+        iterator erase(const_iterator pos)
+        {
+            const size_type i = size_type(pos.m_it - m_values.cbegin());
+            const size_type last = m_values.size() - 1;
+            if(!m_slots.empty())
+            {
+                // The next slots are shifted backward so the probing never stops before a value
+                const size_type mask = m_slots.size() - 1;
+                size_type hole = slot(i);
+                for(size_type j = (hole + 1) & mask; m_slots[j]; j = (j + 1) & mask)
+                {
+                    const size_type h = home(m_values[m_slots[j] - 1u].first, mask);
+                    if(((j - h) & mask) >= ((j - hole) & mask))
+                    {
+                        m_slots[hole] = m_slots[j];
+                        hole = j;
+                    }
+                }
+                m_slots[hole] = 0u;
+                if(i != last)
+                {
+                    m_slots[slot(last)] = uint32_t(i + 1u);
+                }
+            }
+            if(i != last)
+            {
+                m_values[i] = move(m_values[last]);
+            }
+            m_values.pop_back();
+            return iterator(m_values.begin() + i);
+        }
+        
+        //! Removes a value.
+        /** The function removes the value of a tag, the last value is moved to its position.
+         @param tag The tag.
+         @return 1 if the tag was in the map, otherwise 0.
+         */
+        size_type erase(const sTag& tag)
+        {
+            const size_type i = index(tag);
+            if(i != m_values.size())
+            {
+                erase(const_iterator(m_values.cbegin() + i));
+                return 1;
+            }
+            return 0;
+        }
+        
+        //! Removes all the values.
+        /** The function removes all the values.
+         */
+        inline void clear() noexcept
+        {
+            m_values.clear();
+            m_slots.clear();
+        }
+        
+        //! Compares the values with the values of another map.
+        /** The function compares the values of the tags, regardless of the order of insertion.
+         */
+        bool operator==(FlatMap const& other) const noexcept
+        {
+            if(m_values.size() != other.m_values.size())
+            {
+                return false;
+            }
+            for(auto const& value : m_values)
+            {
+                const size_type i = other.index(value.first);
+                if(i == other.m_values.size() || !(other.m_values[i].second == value.second))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        
+        //! Compares the values with the values of another map.
+        inline bool operator!=(FlatMap const& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+}
+
+#endif
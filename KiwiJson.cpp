@@ -0,0 +1,729 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+
+#include "KiwiJson.h"
+#include "KiwiPersistentMap.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      JSON                                        //
+    // ================================================================================ //
+    
+    bool Json::read(string_view text, Atom& atom)
+    {
+        Reader reader(text);
+        Builder builder;
+        if(reader.parse(builder))
+        {
+            atom = move(builder.getAtom());
+            return true;
+        }
+        return false;
+    }
+    
+    bool Json::read(const int fd, Atom& atom)
+    {
+        Reader reader(fd);
+        Builder builder;
+        if(reader.parse(builder))
+        {
+            atom = move(builder.getAtom());
+            return true;
+        }
+        return false;
+    }
+    
+    string Json::write(Atom const& atom, const bool pretty)
+    {
+        Writer writer(pretty);
+        writer.write(atom);
+        return writer.release();
+    }
+    
+    bool Json::write(const int fd, Atom const& atom, const bool pretty)
+    {
+        Writer writer(fd, pretty);
+        writer.write(atom);
+        return writer.flush();
+    }
+    
+    string Json::write(PersistentDico const& dico, const bool pretty)
+    {
+        Writer writer(pretty);
+        writer.write(dico);
+        return writer.release();
+    }
+    
+    bool Json::write(const int fd, PersistentDico const& dico, const bool pretty)
+    {
+        Writer writer(fd, pretty);
+        writer.write(dico);
+        return writer.flush();
+    }
+    
+    // ================================================================================ //
+    //                                      READER                                      //
+    // ================================================================================ //
+    
+    Json::Reader::Reader(string_view text) noexcept :
+    m_it(text.data()),
+    m_end(text.data() + text.size()),
+    m_fd(-1),
+    m_offset(text.size())
+    {
+        ;
+    }
+    
+    Json::Reader::Reader(const int fd, const size_t size) :
+    m_it(nullptr),
+    m_end(nullptr),
+    m_fd(fd),
+    m_buffer(max(size, size_t(1ul))),
+    m_offset(0ul)
+    {
+        ;
+    }
+    
+    bool Json::Reader::refill()
+    {
+        if(m_fd < 0)
+        {
+            return false;
+        }
+#ifdef _WIN32
+        const long size = long(_read(m_fd, m_buffer.data(), unsigned(m_buffer.size())));
+#else
+        long size;
+        do
+        {
+            size = long(::read(m_fd, m_buffer.data(), m_buffer.size()));
+        }
+        while(size < 0 && errno == EINTR);
+#endif
+        if(size <= 0)
+        {
+            return false;
+        }
+        m_it      = m_buffer.data();
+        m_end     = m_it + size;
+        m_offset += size_t(size);
+        return true;
+    }
+    
+    int Json::Reader::space()
+    {
+        int c;
+        while((c = peek()) == ' ' || c == '\n' || c == '\r' || c == '\t')
+        {
+            ++m_it;
+        }
+        return c;
+    }
+    
+    bool Json::Reader::readString(string_view& text)
+    {
+        ++m_it;
+        m_string.clear();
+        bool inplace = true;
+        for(;;)
+        {
+            char const* it = m_it;
+            while(it != m_end && *it != '\"' && *it != '\\' && (unsigned char)*it >= 0x20)
+            {
+                ++it;
+            }
+            
+            // The strings without escape sequence that are in the chunk are read in place
+            if(inplace && it != m_end && *it == '\"')
+            {
+                text = string_view(m_it, size_t(it - m_it));
+                m_it = it + 1;
+                return true;
+            }
+            inplace = false;
+            m_string.append(m_it, size_t(it - m_it));
+            m_it = it;
+            
+            const int c = peek();
+            if(c == '\"')
+            {
+                ++m_it;
+                text = m_string;
+                return true;
+            }
+            else if(c == '\\')
+            {
+                ++m_it;
+                if(!readEscape())
+                {
+                    return false;
+                }
+            }
+            else if(c != -1 && c >= 0x20)
+            {
+                continue;
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+    
+    bool Json::Reader::readEscape()
+    {
+        auto hex = [this]() -> long
+        {
+            long code = 0;
+            for(int i = 0; i < 4; i++)
+            {
+                const int c = peek();
+                if(c == -1 || !isxdigit(c))
+                {
+                    return -1;
+                }
+                ++m_it;
+                code = code * 16 + (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+            }
+            return code;
+        };
+        
+        const int c = peek();
+        if(c == -1)
+        {
+            return false;
+        }
+        ++m_it;
+        switch(c)
+        {
+            case '\"': m_string += '\"'; return true;
+            case '\\': m_string += '\\'; return true;
+            case '/':  m_string += '/'; return true;
+            case 'b':  m_string += '\b'; return true;
+            case 'f':  m_string += '\f'; return true;
+            case 'n':  m_string += '\n'; return true;
+            case 'r':  m_string += '\r'; return true;
+            case 't':  m_string += '\t'; return true;
+            case 'u':  break;
+            default:   return false;
+        }
+        
+        long code = hex();
+        if(code < 0)
+        {
+            return false;
+        }
+        if(code >= 0xD800 && code < 0xDC00)
+        {
+            // A high surrogate must be followed by a low surrogate
+            if(peek() != '\\' || (++m_it, peek()) != 'u')
+            {
+                return false;
+            }
+            ++m_it;
+            const long low = hex();
+            if(low < 0xDC00 || low >= 0xE000)
+            {
+                return false;
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else if(code >= 0xDC00 && code < 0xE000)
+        {
+            // A low surrogate can't be encoded without its high surrogate
+            return false;
+        }
+        
+        appendUtf8(m_string, ulong(code));
+        return true;
+    }
+    
+    bool Json::Reader::readLiteral(char const* word)
+    {
+        for(; *word; ++word)
+        {
+            if(peek() != *word)
+            {
+                return false;
+            }
+            ++m_it;
+        }
+        return true;
+    }
+    
+    //! Checks if a character can be part of a number.
+    static inline bool isNumber(const char c) noexcept
+    {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+    
+    //! Checks if a text follows the grammar of the JSON numbers, the integral part has no leading zero.
+    static bool isValidNumber(char const* it, char const* const last) noexcept
+    {
+        auto digits = [&it, last]()
+        {
+            char const* const first = it;
+            while(it != last && isdigit((unsigned char)*it))
+            {
+                ++it;
+            }
+            return it != first;
+        };
+        
+        if(it != last && *it == '-')
+        {
+            ++it;
+        }
+        if(it != last && *it == '0')
+        {
+            ++it;
+        }
+        else if(!digits())
+        {
+            return false;
+        }
+        if(it != last && *it == '.')
+        {
+            ++it;
+            if(!digits())
+            {
+                return false;
+            }
+        }
+        if(it != last && (*it == 'e' || *it == 'E'))
+        {
+            ++it;
+            if(it != last && (*it == '+' || *it == '-'))
+            {
+                ++it;
+            }
+            if(!digits())
+            {
+                return false;
+            }
+        }
+        return it == last;
+    }
+    
+    bool Json::Reader::readNumber(Atom& atom)
+    {
+        // The numbers that are in the chunk are read in place
+        char const* it = m_it;
+        while(it != m_end && isNumber(*it))
+        {
+            ++it;
+        }
+        char const* first = m_it;
+        char const* last  = it;
+        m_it = it;
+        if(it == m_end && m_fd >= 0)
+        {
+            m_string.assign(first, last);
+            while(peek() != -1 && isNumber(*m_it))
+            {
+                m_string += *m_it++;
+            }
+            first = m_string.data();
+            last  = first + m_string.size();
+        }
+        if(!isValidNumber(first, last))
+        {
+            return false;
+        }
+        
+        if(find_if(first, last, [](const char c) {return c == '.' || c == 'e' || c == 'E';}) == last)
+        {
+            long value;
+            const from_chars_result result = from_chars(first, last, value);
+            if(result.ec == errc() && result.ptr == last)
+            {
+                atom = value;
+                return true;
+            }
+            if(result.ec != errc::result_out_of_range)
+            {
+                return false;
+            }
+            // The integers that don't fit in a long are read as doubles
+        }
+        double value;
+        const from_chars_result result = from_chars(first, last, value);
+        if(result.ec == errc() && result.ptr == last)
+        {
+            atom = value;
+            return true;
+        }
+        return false;
+    }
+    
+    bool Json::Reader::readScalar(const int c, Atom& atom)
+    {
+        switch(c)
+        {
+            case '\"':
+            {
+                string_view text;
+                if(!readString(text))
+                {
+                    return false;
+                }
+                atom = Tag::create(text);
+                return true;
+            }
+            case 't':
+                atom = true;
+                return readLiteral("true");
+            case 'f':
+                atom = false;
+                return readLiteral("false");
+            case 'n':
+                return readLiteral("null");
+            case -1:
+                return false;
+            default:
+                return readNumber(atom);
+        }
+    }
+    
+    // ================================================================================ //
+    //                                      BUILDER                                     //
+    // ================================================================================ //
+    
+    void Json::Builder::add(Atom&& atom)
+    {
+        if(!m_depth)
+        {
+            m_atom = move(atom);
+            return;
+        }
+        Frame& frame = m_frames[m_depth - 1];
+        if(frame.isdico)
+        {
+            frame.dico.insert_or_assign(frame.key, move(atom));
+        }
+        else
+        {
+            frame.vector.push_back(move(atom));
+        }
+    }
+    
+    void Json::Builder::open(const bool dico)
+    {
+        // The frames are kept so the containers of the next values reuse their memory
+        if(m_depth == m_frames.size())
+        {
+            m_frames.emplace_back();
+        }
+        m_frames[m_depth++].isdico = dico;
+    }
+    
+    void Json::Builder::endVector()
+    {
+        Frame& frame = m_frames[--m_depth];
+        Atom atom(move(frame.vector));
+        frame.vector.clear();
+        add(move(atom));
+    }
+    
+    void Json::Builder::endDico()
+    {
+        Frame& frame = m_frames[--m_depth];
+        Atom atom(move(frame.dico));
+        frame.dico.clear();
+        add(move(atom));
+    }
+    
+    // ================================================================================ //
+    //                                      WRITER                                      //
+    // ================================================================================ //
+    
+    Json::Writer::Writer(const bool pretty) noexcept :
+    m_size(string::npos),
+    m_fd(-1),
+    m_stream(nullptr),
+    m_pretty(pretty),
+    m_indent(0ul),
+    m_valid(true)
+    {
+        ;
+    }
+    
+    Json::Writer::Writer(const int fd, const bool pretty, const size_t size) :
+    m_size(size),
+    m_fd(fd),
+    m_stream(nullptr),
+    m_pretty(pretty),
+    m_indent(0ul),
+    m_valid(true)
+    {
+        m_buffer.reserve(size + 256ul);
+    }
+    
+    Json::Writer::Writer(ostream& stream, const bool pretty, const size_t size) :
+    m_size(size),
+    m_fd(-1),
+    m_stream(&stream),
+    m_pretty(pretty),
+    m_indent(0ul),
+    m_valid(true)
+    {
+        ;
+    }
+    
+    Json::Writer::~Writer() noexcept
+    {
+        flush();
+    }
+    
+    bool Json::Writer::flush()
+    {
+        if(m_buffer.empty() || m_size == string::npos)
+        {
+            return m_valid;
+        }
+        if(m_stream)
+        {
+            m_valid = m_stream->write(m_buffer.data(), streamsize(m_buffer.size())) && m_valid;
+        }
+        else
+        {
+            char const* it = m_buffer.data();
+            char const* const end = it + m_buffer.size();
+            while(it != end && m_valid)
+            {
+#ifdef _WIN32
+                const long size = long(_write(m_fd, it, unsigned(end - it)));
+#else
+                const long size = long(::write(m_fd, it, size_t(end - it)));
+                if(size < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+#endif
+                if(size <= 0)
+                {
+                    m_valid = false;
+                }
+                else
+                {
+                    it += size;
+                }
+            }
+        }
+        m_buffer.clear();
+        return m_valid;
+    }
+    
+    void Json::Writer::write(Atom const& atom)
+    {
+        writeValue(atom);
+        if(m_buffer.size() >= m_size)
+        {
+            flush();
+        }
+    }
+    
+    void Json::Writer::write(PersistentDico const& dico)
+    {
+        bool first = true;
+        m_buffer += '{';
+        ++m_indent;
+        dico.forEach([this, &first](sTag const& tag, Atom const& value)
+        {
+            writeEntry(tag, value, first);
+            first = false;
+        });
+        --m_indent;
+        if(!dico.empty())
+        {
+            writeLine();
+        }
+        m_buffer += '}';
+        if(m_buffer.size() >= m_size)
+        {
+            flush();
+        }
+    }
+    
+    void Json::Writer::writeLine()
+    {
+        if(m_pretty)
+        {
+            m_buffer += '\n';
+            m_buffer.append(m_indent, '\t');
+        }
+    }
+    
+    void Json::Writer::writeTag(sTag const& tag)
+    {
+        auto it = m_names.find(tag);
+        if(it == m_names.end())
+        {
+            string& name = m_names[tag];
+            name = jsonEscape(tag->getName());
+            m_buffer += name;
+        }
+        else
+        {
+            m_buffer += it->second;
+        }
+    }
+    
+    void Json::Writer::writeEntry(sTag const& tag, Atom const& value, const bool first)
+    {
+        if(!first)
+        {
+            m_buffer += ',';
+        }
+        writeLine();
+        writeTag(tag);
+        m_buffer += m_pretty ? " : " : ":";
+        writeValue(value);
+        
+        // The buffer is written to the sink in the large containers
+        if(m_buffer.size() >= m_size)
+        {
+            flush();
+        }
+    }
+    
+    template <class T> void Json::Writer::writeNumber(const T value)
+    {
+        // The infinities and the not-a-numbers don't exist in JSON
+        if constexpr(is_floating_point<T>::value)
+        {
+            if(!isfinite(value))
+            {
+                m_buffer += "null";
+                return;
+            }
+        }
+        char text[32];
+        char* end = to_chars(text, text + sizeof(text) - 2, value).ptr;
+        if constexpr(is_floating_point<T>::value)
+        {
+            // The integral numbers keep a fraction so they are read back as doubles
+            if(find_if(text, end, [](const char c) {return c == '.' || c == 'e';}) == end)
+            {
+                *end++ = '.';
+                *end++ = '0';
+            }
+        }
+        m_buffer.append(text, size_t(end - text));
+    }
+    
+    template <class T> void Json::Writer::writeNumbers(T const* values, const size_t size)
+    {
+        m_buffer += '[';
+        for(size_t i = 0; i < size; i++)
+        {
+            if(i)
+            {
+                m_buffer += m_pretty ? ", " : ",";
+            }
+            writeNumber(values[i]);
+        }
+        m_buffer += ']';
+    }
+    
+    void Json::Writer::writeValue(Atom const& atom)
+    {
+        switch(atom.getType())
+        {
+            case Atom::BOOLEAN:
+                m_buffer += bool(atom) ? "true" : "false";
+                break;
+            case Atom::LONG:
+                writeNumber(long(atom));
+                break;
+            case Atom::DOUBLE:
+                writeNumber(double(atom));
+                break;
+            case Atom::TAG:
+                writeTag(sTag(atom));
+                break;
+            case Atom::VECTOR:
+            {
+                Vector const& vector = atom.getVector();
+                m_buffer += '[';
+                for(Vector::size_type i = 0; i < vector.size(); i++)
+                {
+                    if(i)
+                    {
+                        m_buffer += m_pretty ? ", " : ",";
+                    }
+                    writeValue(vector[i]);
+                    
+                    // The buffer is written to the sink in the large containers
+                    if(m_buffer.size() >= m_size)
+                    {
+                        flush();
+                    }
+                }
+                m_buffer += ']';
+                break;
+            }
+            case Atom::DICO:
+            {
+                Dico const& dico = atom.getDico();
+                m_buffer += '{';
+                ++m_indent;
+                for(auto it = dico.begin(); it != dico.end(); ++it)
+                {
+                    writeEntry(it->first, it->second, it == dico.begin());
+                }
+                --m_indent;
+                if(!dico.empty())
+                {
+                    writeLine();
+                }
+                m_buffer += '}';
+                break;
+            }
+            case Atom::DOUBLES:
+                writeNumbers(atom.getDoubles().data(), atom.getDoubles().size());
+                break;
+            case Atom::FLOATS:
+                writeNumbers(atom.getFloats().data(), atom.getFloats().size());
+                break;
+            case Atom::TUPLE:
+            {
+                const Tuple tuple = atom;
+                writeNumbers(tuple.begin(), tuple.size());
+                break;
+            }
+            default:
+                m_buffer += "null";
+                break;
+        }
+    }
+}
@@ -0,0 +1,427 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_JSON__
+#define __DEF_KIWI_JSON__
+
+#include "KiwiAtom.h"
+#include "KiwiTagMap.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      JSON                                        //
+    // ================================================================================ //
+    
+    //! The json reads and writes the atoms in the JSON format.
+    /** The json maps the null to an undefined atom, the booleans to booleans, the integers to longs or to doubles if they don't fit, the other numbers to doubles, the strings to tags, the arrays to vectors and the objects to dicos whose keys are tags, the last value of a key that appears twice is kept.
+     @see Json::Reader, Json::Writer
+     */
+    class Json
+    {
+    public:
+        class Reader;
+        class Builder;
+        class Writer;
+        
+        //! Reads an atom.
+        /** The function reads an atom from a JSON text.
+         @param text The text.
+         @param atom The atom.
+         @return true if the text is valid, otherwise false and the atom is unchanged.
+         */
+        static bool read(string_view text, Atom& atom);
+        
+        //! Reads an atom.
+        /** The function reads an atom from a file descriptor by chunks until the end of the file.
+         @param fd   The file descriptor.
+         @param atom The atom.
+         @return true if the text is valid, otherwise false and the atom is unchanged.
+         */
+        static bool read(const int fd, Atom& atom);
+        
+        //! Writes an atom.
+        /** The function writes an atom in a JSON text.
+         @param atom   The atom.
+         @param pretty If true the dicos are written on several lines and indented, otherwise the text is compact.
+         @return The text.
+         */
+        static string write(Atom const& atom, const bool pretty = false);
+        
+        //! Writes an atom.
+        /** The function writes an atom in a JSON text to a file descriptor.
+         @param fd     The file descriptor.
+         @param atom   The atom.
+         @param pretty If true the dicos are written on several lines and indented, otherwise the text is compact.
+         @return true if the text has been written, otherwise false.
+         */
+        static bool write(const int fd, Atom const& atom, const bool pretty = false);
+        
+        //! Writes a persistent dico.
+        /** The function writes a persistent dico in a JSON text as an object, without copying it in a dico.
+         @param dico   The persistent dico.
+         @param pretty If true the dicos are written on several lines and indented, otherwise the text is compact.
+         @return The text.
+         */
+        static string write(PersistentDico const& dico, const bool pretty = false);
+        
+        //! Writes a persistent dico.
+        /** The function writes a persistent dico in a JSON text to a file descriptor as an object, without copying it in a dico.
+         @param fd     The file descriptor.
+         @param dico   The persistent dico.
+         @param pretty If true the dicos are written on several lines and indented, otherwise the text is compact.
+         @return true if the text has been written, otherwise false.
+         */
+        static bool write(const int fd, PersistentDico const& dico, const bool pretty = false);
+    };
+    
+    // ================================================================================ //
+    //                                      READER                                      //
+    // ================================================================================ //
+    
+    //! The reader parses a JSON text in one pass and notifies a handler of its values.
+    /** The reader notifies the values in the order of the text without building a tree, the handler must implement :
+     @code
+     void value(Atom&& atom);       // A null, a boolean, a number or a string
+     void key(sTag const& tag);     // The key of the next value of an object
+     void beginVector();
+     void endVector();
+     void beginDico();
+     void endDico();
+     @endcode
+     The reader reads a text in memory or a file descriptor by chunks, the containers are tracked in a stack so the depth of the text doesn't use the stack of the thread.
+     @see Json::Builder
+     */
+    class Json::Reader
+    {
+    private:
+        char const*     m_it;
+        char const*     m_end;
+        const int       m_fd;
+        vector<char>    m_buffer;
+        size_t          m_offset;
+        string          m_string;
+        vector<bool>    m_stack;
+        
+        //! Reads the next chunk of the file descriptor.
+        bool refill();
+        
+        //! Retrieves the next character, -1 at the end of the text.
+        inline int peek()
+        {
+            if(m_it == m_end && !refill())
+            {
+                return -1;
+            }
+            return (unsigned char)*m_it;
+        }
+        
+        //! Skips the white spaces and retrieves the next character, -1 at the end of the text.
+        int space();
+        
+        //! Reads a string, the view is valid until the next read.
+        bool readString(string_view& text);
+        
+        //! Reads an escape sequence of a string after its backslash.
+        bool readEscape();
+        
+        //! Reads the characters of a literal.
+        bool readLiteral(char const* word);
+        
+        //! Reads a number.
+        bool readNumber(Atom& atom);
+        
+        //! Reads a null, a boolean, a number or a string.
+        bool readScalar(const int c, Atom& atom);
+        
+        //! Reads the key of an object and its separator.
+        template <class Handler> bool readKey(Handler& handler)
+        {
+            string_view text;
+            if(space() != '\"' || !readString(text))
+            {
+                return false;
+            }
+            handler.key(Tag::create(text));
+            if(space() != ':')
+            {
+                return false;
+            }
+            ++m_it;
+            return true;
+        }
+        
+    public:
+        
+        //! Constructor.
+        /** Creates a reader for a text in memory.
+         @param text The text, it must remain valid until the end of the parsing.
+         */
+        Reader(string_view text) noexcept;
+        
+        //! Constructor.
+        /** Creates a reader for a file descriptor, the file isn't closed by the reader.
+         @param fd   The file descriptor.
+         @param size The size of the chunks.
+         */
+        Reader(const int fd, const size_t size = 65536ul);
+        
+        //! Destructor.
+        inline ~Reader() noexcept {}
+        
+        //! Retrieve the position in the text.
+        /** The function retrieves the number of characters read, after a failure this is the position of the error.
+         @return The position.
+         */
+        inline size_t getPosition() const noexcept
+        {
+            return m_offset - size_t(m_end - m_it);
+        }
+        
+        //! Parses the text.
+        /** The function parses a value and notifies the handler, only white spaces can follow the value.
+         @param handler The handler.
+         @return true if the text is valid, otherwise false and the parsing stops at the error.
+         */
+        template <class Handler> bool parse(Handler& handler)
+        {
+            m_stack.clear();
+            for(;;)
+            {
+                int c = space();
+                if(c == '[' || c == '{')
+                {
+                    ++m_it;
+                    const bool dico = c == '{';
+                    dico ? handler.beginDico() : handler.beginVector();
+                    if(space() != (dico ? '}' : ']'))
+                    {
+                        m_stack.push_back(dico);
+                        if(dico && !readKey(handler))
+                        {
+                            return false;
+                        }
+                        continue;
+                    }
+                    ++m_it;
+                    dico ? handler.endDico() : handler.endVector();
+                }
+                else
+                {
+                    Atom atom;
+                    if(!readScalar(c, atom))
+                    {
+                        return false;
+                    }
+                    handler.value(move(atom));
+                }
+                
+                // The containers that end after the value are closed
+                for(;;)
+                {
+                    if(m_stack.empty())
+                    {
+                        return space() == -1;
+                    }
+                    const bool dico = m_stack.back();
+                    c = space();
+                    if(c == ',')
+                    {
+                        ++m_it;
+                        if(dico && !readKey(handler))
+                        {
+                            return false;
+                        }
+                        break;
+                    }
+                    if(c != (dico ? '}' : ']'))
+                    {
+                        return false;
+                    }
+                    ++m_it;
+                    m_stack.pop_back();
+                    dico ? handler.endDico() : handler.endVector();
+                }
+            }
+        }
+    };
+    
+    // ================================================================================ //
+    //                                      BUILDER                                     //
+    // ================================================================================ //
+    
+    //! The builder is the handler of the reader that builds an atom.
+    /** The builder fills the vectors and the dicos of the containers that are open and moves them in their parent when they are closed. The memory of the atoms is allocated from the arena of the current thread if a scope is active.
+     @see Json::Reader
+     */
+    class Json::Builder
+    {
+    private:
+        struct Frame
+        {
+            Vector  vector;
+            Dico    dico;
+            sTag    key;
+            bool    isdico;
+        };
+        
+        vector<Frame>   m_frames;
+        size_t          m_depth;
+        Atom            m_atom;
+        
+        //! Adds a value to the container that is open or sets the atom.
+        void add(Atom&& atom);
+        
+        //! Opens a container.
+        void open(const bool dico);
+        
+    public:
+        
+        //! Constructor.
+        inline Builder() noexcept : m_depth(0ul) {}
+        
+        //! Destructor.
+        inline ~Builder() noexcept {}
+        
+        //! Retrieve the atom.
+        /** The function retrieves the atom built once the parsing is done.
+         @return The atom.
+         */
+        inline Atom& getAtom() noexcept {return m_atom;}
+        
+        inline void value(Atom&& atom) {add(move(atom));}
+        inline void key(sTag const& tag) {m_frames[m_depth - 1].key = tag;}
+        inline void beginVector() {open(false);}
+        inline void beginDico() {open(true);}
+        void endVector();
+        void endDico();
+    };
+    
+    // ================================================================================ //
+    //                                      WRITER                                      //
+    // ================================================================================ //
+    
+    //! The writer writes the atoms in a JSON text through a buffer.
+    /** The writer appends the text to a buffer that is written to its sink, a file descriptor or a stream, when it is full and when the writer is flushed or destroyed, without a buffer the text is kept in memory. The quoted and escaped names of the tags are cached so each tag is escaped once by writer. The undefined atoms are written as null, the tuples and the buffers as arrays of numbers. In the pretty mode the entries of the dicos are written on separate lines indented with tabulations, in the compact mode the text has no white space.
+     @see Json::Reader
+     */
+    class Json::Writer
+    {
+    private:
+        string          m_buffer;
+        const size_t    m_size;
+        const int       m_fd;
+        ostream* const  m_stream;
+        const bool      m_pretty;
+        ulong           m_indent;
+        bool            m_valid;
+        TagMap<string>  m_names;
+        
+        //! Writes a value.
+        void writeValue(Atom const& atom);
+        
+        //! Writes the quoted and escaped name of a tag.
+        void writeTag(sTag const& tag);
+        
+        //! Writes an entry of a dico.
+        void writeEntry(sTag const& tag, Atom const& value, const bool first);
+        
+        //! Writes a number.
+        template <class T> void writeNumber(const T value);
+        
+        //! Writes numbers as an array.
+        template <class T> void writeNumbers(T const* values, const size_t size);
+        
+        //! Writes a line break and the indentation in the pretty mode.
+        void writeLine();
+        
+    public:
+        
+        //! Constructor.
+        /** Creates a writer that keeps the text in memory.
+         @param pretty The pretty mode.
+         */
+        Writer(const bool pretty = false) noexcept;
+        
+        //! Constructor.
+        /** Creates a writer to a file descriptor, the file isn't closed by the writer.
+         @param fd     The file descriptor.
+         @param pretty The pretty mode.
+         @param size   The size of the buffer.
+         */
+        Writer(const int fd, const bool pretty = false, const size_t size = 65536ul);
+        
+        //! Constructor.
+        /** Creates a writer to a stream, the stream isn't flushed by the writer.
+         @param stream The stream.
+         @param pretty The pretty mode.
+         @param size   The size of the buffer.
+         */
+        Writer(ostream& stream, const bool pretty = false, const size_t size = 65536ul);
+        
+        //! Destructor.
+        /** The buffer is written to the sink.
+         */
+        ~Writer() noexcept;
+        
+        Writer(Writer const&) = delete;
+        Writer& operator=(Writer const&) = delete;
+        
+        //! Writes an atom.
+        /** The function appends an atom to the text.
+         @param atom The atom.
+         */
+        void write(Atom const& atom);
+        
+        //! Writes a persistent dico.
+        /** The function appends a persistent dico to the text as an object, the entries are visited in the order of the hashes of their tags.
+         @param dico The persistent dico.
+         */
+        void write(PersistentDico const& dico);
+        
+        //! Writes the buffer to the sink.
+        /** The function writes the buffer to the file descriptor or to the stream, it does nothing if the text is kept in memory.
+         @return false if an error occured since the creation of the writer, otherwise true.
+         */
+        bool flush();
+        
+        //! Retrieve the text.
+        /** The function retrieves the text kept in memory or the part of the text that hasn't been written to the sink.
+         @return The text.
+         */
+        inline string_view getText() const noexcept {return m_buffer;}
+        
+        //! Takes the text.
+        /** The function retrieves the text kept in memory and clears the writer.
+         @return The text.
+         */
+        inline string release() noexcept
+        {
+            string text(move(m_buffer));
+            m_buffer.clear();
+            return text;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,468 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_PERSISTENTMAP__
+#define __DEF_KIWI_PERSISTENTMAP__
+
+#include "KiwiFlatMap.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                  PERSISTENT MAP                                  //
+    // ================================================================================ //
+    
+    //! The persistent map is an associative container indexed by tags whose versions share their memory.
+    /** The persistent map is a hash array mapped trie : each node uses 5 bits of the hash of a tag to select a value or a child node, the tags whose hashes are equal are stored in the nodes at the bottom of the trie. The copy of a map only retains its root, so it is a snapshot in constant time. A modification copies the nodes on the path of the tag that are shared with other versions and modifies the others in place, so the memory of the versions is proportional to their differences. The nodes are counted atomically so the versions of a map can be used by different threads, a version must be used by one thread at a time. The tags must be valid.
+     @see Dico
+     */
+    template <class T> class PersistentMap
+    {
+    public:
+        typedef sTag                key_type;
+        typedef T                   mapped_type;
+        typedef pair<sTag, T>       value_type;
+        typedef size_t              size_type;
+        
+    private:
+        static const unsigned bits = 5u;
+        static const unsigned mask = 31u;
+        
+        class Node
+        {
+        public:
+            mutable atomic<ulong>   refs;
+            uint32_t                datamap;
+            uint32_t                nodemap;
+            vector<value_type>      values;
+            vector<Node*>           children;
+            
+            inline Node() noexcept : refs(1ul), datamap(0u), nodemap(0u) {}
+            
+            Node(Node const& other) : refs(1ul), datamap(other.datamap), nodemap(other.nodemap), values(other.values), children(other.children)
+            {
+                for(Node* child : children)
+                {
+                    child->retain();
+                }
+            }
+            
+            ~Node() noexcept
+            {
+                for(Node* child : children)
+                {
+                    child->release();
+                }
+            }
+            
+            inline Node* retain() noexcept
+            {
+                refs.fetch_add(1ul, memory_order_relaxed);
+                return this;
+            }
+            
+            inline void release() noexcept
+            {
+                if(refs.fetch_sub(1ul, memory_order_acq_rel) == 1ul)
+                {
+                    delete this;
+                }
+            }
+        };
+        
+        Node*       m_root;
+        size_type   m_size;
+        
+        //! Retrieves the position of a bit in the values or the children of a node.
+        static inline size_t index(const uint32_t map, const uint32_t bit) noexcept
+        {
+            return bitset<32>(map & (bit - 1u)).count();
+        }
+        
+        //! Retrieves the bit of a hash for a level of the trie.
+        static inline uint32_t bit(const ulong hash, const unsigned shift) noexcept
+        {
+            return 1u << ((hash >> shift) & mask);
+        }
+        
+        //! Retrieves a node that isn't shared, copying the node if needed.
+        static Node* own(Node*& slot)
+        {
+            if(slot->refs.load(memory_order_acquire) != 1ul)
+            {
+                Node* copy = new Node(*slot);
+                slot->release();
+                slot = copy;
+            }
+            return slot;
+        }
+        
+        //! Creates a node with two values whose tags differ.
+        template <class V> static Node* merge(const unsigned shift, value_type&& entry, const ulong ehash, const sTag& key, V&& value, const ulong hash)
+        {
+            Node* node = new Node();
+            if(shift >= 64u)
+            {
+                node->values.push_back(move(entry));
+                node->values.emplace_back(key, forward<V>(value));
+                return node;
+            }
+            const uint32_t ebit = bit(ehash, shift), vbit = bit(hash, shift);
+            if(ebit == vbit)
+            {
+                node->nodemap = vbit;
+                node->children.push_back(merge(shift + bits, move(entry), ehash, key, forward<V>(value), hash));
+            }
+            else
+            {
+                node->datamap = ebit | vbit;
+                node->values.reserve(2);
+                if(ebit < vbit)
+                {
+                    node->values.push_back(move(entry));
+                    node->values.emplace_back(key, forward<V>(value));
+                }
+                else
+                {
+                    node->values.emplace_back(key, forward<V>(value));
+                    node->values.push_back(move(entry));
+                }
+            }
+            return node;
+        }
+        
+        //! Inserts or replaces a value in a node, returns true if the value has been inserted.
+        template <class V> static bool assign(Node*& slot, const unsigned shift, const ulong hash, const sTag& key, V&& value)
+        {
+            Node* node = own(slot);
+            if(shift >= 64u)
+            {
+                for(auto& entry : node->values)
+                {
+                    if(entry.first == key)
+                    {
+                        entry.second = forward<V>(value);
+                        return false;
+                    }
+                }
+                node->values.emplace_back(key, forward<V>(value));
+                return true;
+            }
+            
+            const uint32_t b = bit(hash, shift);
+            if(node->nodemap & b)
+            {
+                return assign(node->children[index(node->nodemap, b)], shift + bits, hash, key, forward<V>(value));
+            }
+            const size_t i = index(node->datamap, b);
+            if(node->datamap & b)
+            {
+                value_type& entry = node->values[i];
+                if(entry.first == key)
+                {
+                    entry.second = forward<V>(value);
+                    return false;
+                }
+                
+                // The value that uses the same bits is moved with the new one in a child node
+                const ulong ehash = entry.first->getHash();
+                Node* child = merge(shift + bits, move(entry), ehash, key, forward<V>(value), hash);
+                node->values.erase(node->values.begin() + ptrdiff_t(i));
+                node->datamap &= ~b;
+                node->children.insert(node->children.begin() + ptrdiff_t(index(node->nodemap, b)), child);
+                node->nodemap |= b;
+                return true;
+            }
+            node->values.emplace(node->values.begin() + ptrdiff_t(i), key, forward<V>(value));
+            node->datamap |= b;
+            return true;
+        }
+        
+        //! Removes the value of a tag that is in a node.
+        static void remove(Node*& slot, const unsigned shift, const ulong hash, const sTag& key)
+        {
+            Node* node = own(slot);
+            if(shift >= 64u)
+            {
+                for(size_t i = 0; i < node->values.size(); i++)
+                {
+                    if(node->values[i].first == key)
+                    {
+                        node->values.erase(node->values.begin() + ptrdiff_t(i));
+                        return;
+                    }
+                }
+                return;
+            }
+            
+            const uint32_t b = bit(hash, shift);
+            if(node->nodemap & b)
+            {
+                const size_t j = index(node->nodemap, b);
+                Node*& child = node->children[j];
+                remove(child, shift + bits, hash, key);
+                
+                // A child with only one value is replaced by its value so the trie remains as short as possible
+                if(!child->nodemap && child->values.size() == 1)
+                {
+                    value_type entry(move(child->values.front()));
+                    child->release();
+                    node->children.erase(node->children.begin() + ptrdiff_t(j));
+                    node->nodemap &= ~b;
+                    node->values.insert(node->values.begin() + ptrdiff_t(index(node->datamap, b)), move(entry));
+                    node->datamap |= b;
+                }
+                return;
+            }
+            node->values.erase(node->values.begin() + ptrdiff_t(index(node->datamap, b)));
+            node->datamap &= ~b;
+        }
+        
+        //! Calls a function with the values of a node and of its children.
+        template <class F> static void walk(Node const* node, F& function)
+        {
+            for(auto const& entry : node->values)
+            {
+                function(entry.first, entry.second);
+            }
+            for(Node const* child : node->children)
+            {
+                walk(child, function);
+            }
+        }
+        
+    public:
+        
+        //! Constructor.
+        /** Creates an empty map.
+         */
+        inline PersistentMap() noexcept : m_root(nullptr), m_size(0) {}
+        
+        //! Constructor.
+        /** Creates a map with the values of a flat map.
+         */
+        explicit PersistentMap(FlatMap<T> const& map) : m_root(nullptr), m_size(0)
+        {
+            for(auto const& entry : map)
+            {
+                assign(entry.first, entry.second);
+            }
+        }
+        
+        //! Constructor.
+        /** Creates a map with a list of values, the last value of a tag is kept.
+         */
+        PersistentMap(initializer_list<value_type> il) : m_root(nullptr), m_size(0)
+        {
+            for(auto const& entry : il)
+            {
+                assign(entry.first, entry.second);
+            }
+        }
+        
+        //! Constructor.
+        /** Creates a version that shares the nodes of another version.
+         */
+        inline PersistentMap(PersistentMap const& other) noexcept : m_root(other.m_root ? other.m_root->retain() : nullptr), m_size(other.m_size) {}
+        
+        //! Constructor.
+        /** Creates a map with the nodes of another map.
+         */
+        inline PersistentMap(PersistentMap&& other) noexcept : m_root(other.m_root), m_size(other.m_size)
+        {
+            other.m_root = nullptr;
+            other.m_size = 0;
+        }
+        
+        //! Destructor.
+        /** Releases the nodes.
+         */
+        inline ~PersistentMap() noexcept
+        {
+            if(m_root)
+            {
+                m_root->release();
+            }
+        }
+        
+        //! Replaces the map with another version.
+        inline PersistentMap& operator=(PersistentMap const& other) noexcept
+        {
+            PersistentMap copy(other);
+            swap(copy);
+            return *this;
+        }
+        
+        //! Replaces the map with another map.
+        inline PersistentMap& operator=(PersistentMap&& other) noexcept
+        {
+            PersistentMap copy(move(other));
+            swap(copy);
+            return *this;
+        }
+        
+        //! Swaps the nodes with another map.
+        inline void swap(PersistentMap& other) noexcept
+        {
+            std::swap(m_root, other.m_root);
+            std::swap(m_size, other.m_size);
+        }
+        
+        inline size_type size() const noexcept {return m_size;}
+        inline bool empty() const noexcept {return !m_size;}
+        
+        //! Retrieves a value.
+        /** The function retrieves the value of a tag.
+         @param tag The tag.
+         @return A pointer to the value or nullptr if the tag isn't in the map.
+         */
+        T const* find(const sTag& tag) const noexcept
+        {
+            const ulong hash = tag->getHash();
+            Node const* node = m_root;
+            for(unsigned shift = 0u; node; shift += bits)
+            {
+                if(shift >= 64u)
+                {
+                    for(auto const& entry : node->values)
+                    {
+                        if(entry.first == tag)
+                        {
+                            return &entry.second;
+                        }
+                    }
+                    return nullptr;
+                }
+                const uint32_t b = bit(hash, shift);
+                if(node->datamap & b)
+                {
+                    value_type const& entry = node->values[index(node->datamap, b)];
+                    return entry.first == tag ? &entry.second : nullptr;
+                }
+                node = (node->nodemap & b) ? node->children[index(node->nodemap, b)] : nullptr;
+            }
+            return nullptr;
+        }
+        
+        //! Checks if a tag is in the map.
+        /** The function checks if a tag is in the map.
+         @param tag The tag.
+         @return 1 if the tag is in the map, otherwise 0.
+         */
+        inline size_type count(const sTag& tag) const noexcept
+        {
+            return find(tag) ? 1 : 0;
+        }
+        
+        //! Inserts or replaces a value.
+        /** The function inserts a value or replaces the value of the tag in this version, the nodes shared with other versions are copied.
+         @param tag   The tag.
+         @param value The value.
+         @return true if the value has been inserted.
+         */
+        template <class V> bool assign(const sTag& tag, V&& value)
+        {
+            if(!m_root)
+            {
+                m_root = new Node();
+            }
+            const bool inserted = assign(m_root, 0u, tag->getHash(), tag, forward<V>(value));
+            m_size += inserted ? 1 : 0;
+            return inserted;
+        }
+        
+        //! Removes a value.
+        /** The function removes the value of a tag from this version, the nodes shared with other versions are copied.
+         @param tag The tag.
+         @return 1 if the tag was in the map, otherwise 0.
+         */
+        size_type erase(const sTag& tag)
+        {
+            if(!find(tag))
+            {
+                return 0;
+            }
+            if(--m_size)
+            {
+                remove(m_root, 0u, tag->getHash(), tag);
+            }
+            else
+            {
+                m_root->release();
+                m_root = nullptr;
+            }
+            return 1;
+        }
+        
+        //! Creates a version with a value.
+        /** The function creates a version of the map that shares the nodes of this version except on the path of the tag.
+         @param tag   The tag.
+         @param value The value.
+         @return The new version.
+         */
+        template <class V> PersistentMap set(const sTag& tag, V&& value) const
+        {
+            PersistentMap version(*this);
+            version.assign(tag, forward<V>(value));
+            return version;
+        }
+        
+        //! Creates a version without a value.
+        /** The function creates a version of the map that shares the nodes of this version except on the path of the tag.
+         @param tag The tag.
+         @return The new version.
+         */
+        PersistentMap without(const sTag& tag) const
+        {
+            PersistentMap version(*this);
+            version.erase(tag);
+            return version;
+        }
+        
+        //! Calls a function with the values.
+        /** The function calls a function with each tag and its value, the order depends on the hashes of the tags.
+         @param function The function called with a sTag const& and a T const&.
+         */
+        template <class F> void forEach(F&& function) const
+        {
+            if(m_root)
+            {
+                walk(m_root, function);
+            }
+        }
+        
+        //! Copies the values in a flat map.
+        /** The function creates a flat map with the values of this version. A version can also be written with Json::write or Binary::write without being copied.
+         @return The flat map.
+         */
+        FlatMap<T> toFlatMap() const
+        {
+            FlatMap<T> map;
+            map.reserve(m_size);
+            forEach([&map](const sTag& tag, T const& value) {map.emplace(tag, value);});
+            return map;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,508 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_SMALLVECTOR__
+#define __DEF_KIWI_SMALLVECTOR__
+
+#include "KiwiArena.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                  SMALL VECTOR                                    //
+    // ================================================================================ //
+    
+    //! The small vector is a vector that stores its first elements in place.
+    /** The small vector has the interface of a vector but the first N elements are stored inside the object, the memory is only allocated when the vector grows beyond this capacity, from the arena of the current thread if any. It's used for the messages that mostly have a few atoms. The elements must be movable without exception.
+     @see Vector
+     */
+    template <class T, ulong N> class SmallVector
+    {
+    public:
+        typedef T                                       value_type;
+        typedef size_t                                  size_type;
+        typedef ptrdiff_t                               difference_type;
+        typedef T&                                      reference;
+        typedef T const&                                const_reference;
+        typedef T*                                      pointer;
+        typedef T const*                                const_pointer;
+        typedef T*                                      iterator;
+        typedef T const*                                const_iterator;
+        typedef std::reverse_iterator<iterator>         reverse_iterator;
+        typedef std::reverse_iterator<const_iterator>   const_reverse_iterator;
+    
+    private:
+        T*          m_data;
+        size_type   m_size;
+        size_type   m_capacity;
+        alignas(T) unsigned char m_inline[N * sizeof(T)];
+        
+        //! Retrieves the storage in place.
+        inline T* local() noexcept {return reinterpret_cast<T*>(m_inline);}
+        
+        //! Checks if the elements are stored in place.
+        inline bool isLocal() const noexcept {return m_data == reinterpret_cast<T const*>(m_inline);}
+        
+        //! Destroys the elements and frees the memory, the vector must be reinitialized.
+        inline void release() noexcept
+        {
+            for(size_type i = 0; i < m_size; i++)
+            {
+                m_data[i].~T();
+            }
+            if(!isLocal())
+            {
+                Arena::deallocate(m_data);
+            }
+        }
+        
+        //! Retrieves a capacity greater than or equal to a size.
+        inline size_type grow(const size_type size) const noexcept
+        {
+            return max(size, m_capacity * 2);
+        }
+        
+        //! Moves the elements to a new memory of a given capacity, the elements are moved in place if they fit.
+        void reallocate(const size_type capacity)
+        {
+            T* data = capacity <= N ? local() : static_cast<T*>(Arena::allocate(capacity * sizeof(T)));
+            for(size_type i = 0; i < m_size; i++)
+            {
+                new(data + i) T(move(m_data[i]));
+                m_data[i].~T();
+            }
+            if(!isLocal())
+            {
+                Arena::deallocate(m_data);
+            }
+            m_data      = data;
+            m_capacity  = capacity;
+        }
+        
+        //! Opens a gap of a number of elements at an index and returns the position.
+        /** The elements after the gap are moved, the gap must be filled by constructing the elements in place.
+         */
+        iterator open(const size_type index, const size_type count)
+        {
+            if(!count)
+            {
+                return m_data + index;
+            }
+            if(m_size + count > m_capacity)
+            {
+                const size_type capacity = grow(m_size + count);
+                T* data = static_cast<T*>(Arena::allocate(capacity * sizeof(T)));
+                for(size_type i = 0; i < index; i++)
+                {
+                    new(data + i) T(move(m_data[i]));
+                    m_data[i].~T();
+                }
+                for(size_type i = index; i < m_size; i++)
+                {
+                    new(data + i + count) T(move(m_data[i]));
+                    m_data[i].~T();
+                }
+                if(!isLocal())
+                {
+                    Arena::deallocate(m_data);
+                }
+                m_data      = data;
+                m_capacity  = capacity;
+            }
+            else
+            {
+                for(size_type i = m_size; i > index; i--)
+                {
+                    new(m_data + i - 1 + count) T(move(m_data[i - 1]));
+                    m_data[i - 1].~T();
+                }
+            }
+            m_size += count;
+            return m_data + index;
+        }
+    
+    public:
+        
+        //! Constructor.
+        /** Creates an empty vector.
+         */
+        inline SmallVector() noexcept : m_data(local()), m_size(0), m_capacity(N) {}
+        
+        //! Constructor.
+        /** Creates a vector with a number of default elements.
+         @param count The number of elements.
+         */
+        explicit SmallVector(const size_type count) : SmallVector()
+        {
+            resize(count);
+        }
+        
+        //! Constructor.
+        /** Creates a vector with a number of copies of an element.
+         @param count The number of elements.
+         @param value The element.
+         */
+        SmallVector(const size_type count, T const& value) : SmallVector()
+        {
+            reserve(count);
+            for(size_type i = 0; i < count; i++)
+            {
+                new(m_data + i) T(value);
+            }
+            m_size = count;
+        }
+        
+        //! Constructor.
+        /** Creates a vector with the elements of a range.
+         @param first The beginning of the range.
+         @param last  The end of the range.
+         */
+        template <class InputIt, class = typename iterator_traits<InputIt>::iterator_category>
+        SmallVector(InputIt first, InputIt last) : SmallVector()
+        {
+            insert(end(), first, last);
+        }
+        
+        //! Constructor.
+        /** Creates a vector with the elements of a list.
+         @param il The list of elements.
+         */
+        SmallVector(initializer_list<T> il) : SmallVector(il.begin(), il.end()) {}
+        
+        //! Constructor.
+        /** Creates a vector with the copies of the elements of another vector.
+         @param other The other vector.
+         */
+        SmallVector(SmallVector const& other) : SmallVector(other.begin(), other.end()) {}
+        
+        //! Constructor.
+        /** Creates a vector with the elements of another vector, the other vector is left empty.
+         @param other The other vector.
+         */
+        SmallVector(SmallVector&& other) noexcept : SmallVector()
+        {
+            swap(other);
+        }
+        
+        //! Destructor.
+        /** Destroys the elements.
+         */
+        inline ~SmallVector() noexcept {release();}
+        
+        //! Assigns the copies of the elements of another vector.
+        SmallVector& operator=(SmallVector const& other)
+        {
+            if(this != &other)
+            {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+        
+        //! Assigns the elements of another vector, the other vector is left empty.
+        SmallVector& operator=(SmallVector&& other) noexcept
+        {
+            if(this != &other)
+            {
+                clear();
+                swap(other);
+            }
+            return *this;
+        }
+        
+        //! Assigns the elements of a list.
+        SmallVector& operator=(initializer_list<T> il)
+        {
+            assign(il.begin(), il.end());
+            return *this;
+        }
+        
+        //! Replaces the elements with the elements of a range.
+        template <class InputIt, class = typename iterator_traits<InputIt>::iterator_category>
+        void assign(InputIt first, InputIt last)
+        {
+            clear();
+            insert(end(), first, last);
+        }
+        
+        inline iterator begin() noexcept {return m_data;}
+        inline const_iterator begin() const noexcept {return m_data;}
+        inline const_iterator cbegin() const noexcept {return m_data;}
+        inline iterator end() noexcept {return m_data + m_size;}
+        inline const_iterator end() const noexcept {return m_data + m_size;}
+        inline const_iterator cend() const noexcept {return m_data + m_size;}
+        inline reverse_iterator rbegin() noexcept {return reverse_iterator(end());}
+        inline const_reverse_iterator rbegin() const noexcept {return const_reverse_iterator(end());}
+        inline reverse_iterator rend() noexcept {return reverse_iterator(begin());}
+        inline const_reverse_iterator rend() const noexcept {return const_reverse_iterator(begin());}
+        
+        inline size_type size() const noexcept {return m_size;}
+        inline size_type capacity() const noexcept {return m_capacity;}
+        inline bool empty() const noexcept {return m_size == 0;}
+        inline T* data() noexcept {return m_data;}
+        inline T const* data() const noexcept {return m_data;}
+        
+        inline T& operator[](const size_type i) noexcept {return m_data[i];}
+        inline T const& operator[](const size_type i) const noexcept {return m_data[i];}
+        inline T& front() noexcept {return m_data[0];}
+        inline T const& front() const noexcept {return m_data[0];}
+        inline T& back() noexcept {return m_data[m_size - 1];}
+        inline T const& back() const noexcept {return m_data[m_size - 1];}
+        
+        //! Reserves the memory for a number of elements.
+        void reserve(const size_type capacity)
+        {
+            if(capacity > m_capacity)
+            {
+                reallocate(capacity);
+            }
+        }
+        
+        //! Frees the memory that isn't used, the elements are moved in place if they fit.
+        void shrink_to_fit()
+        {
+            if(!isLocal() && m_size < m_capacity)
+            {
+                reallocate(max(m_size, size_type(N)));
+            }
+        }
+        
+        //! Destroys the elements, the memory is kept.
+        inline void clear() noexcept
+        {
+            for(size_type i = 0; i < m_size; i++)
+            {
+                m_data[i].~T();
+            }
+            m_size = 0;
+        }
+        
+        //! Constructs an element at the end.
+        template <class ...Args> T& emplace_back(Args&& ...args)
+        {
+            if(m_size == m_capacity)
+            {
+                // The element is created first because the arguments can refer to an element
+                T value(forward<Args>(args)...);
+                reallocate(grow(m_size + 1));
+                new(m_data + m_size) T(move(value));
+            }
+            else
+            {
+                new(m_data + m_size) T(forward<Args>(args)...);
+            }
+            return m_data[m_size++];
+        }
+        
+        inline void push_back(T const& value) {emplace_back(value);}
+        inline void push_back(T&& value) {emplace_back(move(value));}
+        
+        //! Destroys the last element.
+        inline void pop_back() noexcept
+        {
+            m_data[--m_size].~T();
+        }
+        
+        //! Changes the number of elements, the new elements are default constructed.
+        void resize(const size_type size)
+        {
+            reserve(size);
+            while(m_size > size)
+            {
+                pop_back();
+            }
+            for(; m_size < size; m_size++)
+            {
+                new(m_data + m_size) T();
+            }
+        }
+        
+        //! Changes the number of elements, the new elements are copies of a value.
+        void resize(const size_type size, T const& value)
+        {
+            if(size > m_size)
+            {
+                insert(end(), size - m_size, value);
+            }
+            while(m_size > size)
+            {
+                pop_back();
+            }
+        }
+        
+        //! Inserts an element before a position.
+        iterator insert(const_iterator pos, T const& value)
+        {
+            return emplace(pos, value);
+        }
+        
+        //! Inserts an element before a position.
+        iterator insert(const_iterator pos, T&& value)
+        {
+            return emplace(pos, move(value));
+        }
+        
+        //! Inserts a number of copies of an element before a position.
+        iterator insert(const_iterator pos, const size_type count, T const& value)
+        {
+            const T copy(value);
+            iterator it = open(size_type(pos - m_data), count);
+            for(size_type i = 0; i < count; i++)
+            {
+                new(it + i) T(copy);
+            }
+            return it;
+        }
+        
+        //! Inserts the elements of a range before a position.
+        template <class InputIt, class = typename iterator_traits<InputIt>::iterator_category>
+        iterator insert(const_iterator pos, InputIt first, InputIt last)
+        {
+            const size_type index = size_type(pos - m_data);
+            if constexpr(is_base_of<forward_iterator_tag, typename iterator_traits<InputIt>::iterator_category>::value)
+            {
+                // The range must not belong to the vector
+                const size_type count = size_type(distance(first, last));
+                iterator it = open(index, count);
+                for(size_type i = 0; first != last; ++first, i++)
+                {
+                    new(it + i) T(*first);
+                }
+                return it;
+            }
+            for(size_type i = index; first != last; ++first, i++)
+            {
+                emplace(m_data + i, *first);
+            }
+            return m_data + index;
+        }
+        
+        //! Inserts the elements of a list before a position.
+        iterator insert(const_iterator pos, initializer_list<T> il)
+        {
+            return insert(pos, il.begin(), il.end());
+        }
+        
+        //! Constructs an element before a position.
+        template <class ...Args> iterator emplace(const_iterator pos, Args&& ...args)
+        {
+            T value(forward<Args>(args)...);
+            iterator it = open(size_type(pos - m_data), 1);
+            new(it) T(move(value));
+            return it;
+        }
+        
+        //! Destroys an element.
+        iterator erase(const_iterator pos) noexcept
+        {
+            return erase(pos, pos + 1);
+        }
+        
+        //! Destroys the elements of a range.
+        iterator erase(const_iterator first, const_iterator last) noexcept
+        {
+            iterator it = m_data + (first - m_data);
+            const size_type count = size_type(last - first);
+            if(count)
+            {
+                move(it + count, end(), it);
+                for(size_type i = m_size - count; i < m_size; i++)
+                {
+                    m_data[i].~T();
+                }
+                m_size -= count;
+            }
+            return it;
+        }
+        
+        //! Swaps the elements with another vector.
+        void swap(SmallVector& other) noexcept
+        {
+            SmallVector* lhs = this;
+            SmallVector* rhs = &other;
+            if(!lhs->isLocal() && !rhs->isLocal())
+            {
+                std::swap(m_data, other.m_data);
+                std::swap(m_size, other.m_size);
+                std::swap(m_capacity, other.m_capacity);
+            }
+            else
+            {
+                // The left vector is the one that stores its elements in place
+                if(!lhs->isLocal())
+                {
+                    std::swap(lhs, rhs);
+                }
+                if(!rhs->isLocal())
+                {
+                    // The elements in place are moved and the memory is given to the other vector
+                    T* data = rhs->m_data;
+                    const size_type size = rhs->m_size;
+                    const size_type capacity = rhs->m_capacity;
+                    rhs->m_data = rhs->local();
+                    rhs->m_capacity = N;
+                    for(size_type i = 0; i < lhs->m_size; i++)
+                    {
+                        new(rhs->m_data + i) T(move(lhs->m_data[i]));
+                        lhs->m_data[i].~T();
+                    }
+                    rhs->m_size = lhs->m_size;
+                    lhs->m_data = data;
+                    lhs->m_size = size;
+                    lhs->m_capacity = capacity;
+                }
+                else
+                {
+                    if(lhs->m_size < rhs->m_size)
+                    {
+                        std::swap(lhs, rhs);
+                    }
+                    for(size_type i = 0; i < rhs->m_size; i++)
+                    {
+                        std::swap(lhs->m_data[i], rhs->m_data[i]);
+                    }
+                    for(size_type i = rhs->m_size; i < lhs->m_size; i++)
+                    {
+                        new(rhs->m_data + i) T(move(lhs->m_data[i]));
+                        lhs->m_data[i].~T();
+                    }
+                    std::swap(lhs->m_size, rhs->m_size);
+                }
+            }
+        }
+        
+        //! Compares the elements with the elements of another vector.
+        inline bool operator==(SmallVector const& other) const noexcept
+        {
+            return m_size == other.m_size && equal(begin(), end(), other.begin());
+        }
+        
+        //! Compares the elements with the elements of another vector.
+        inline bool operator!=(SmallVector const& other) const noexcept
+        {
+            return !(*this == other);
+        }
+    };
+}
+
+#endif
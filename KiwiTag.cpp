@@ -26,87 +26,846 @@
 
 namespace Kiwi
 {    
-    map<string, sTag> Tag::m_tags;
-    mutex Tag::m_mutex;
-    
-    const sTag Tags::_empty                = Tag::create("");
-    const sTag Tags::arguments             = Tag::create("arguments");
-    const sTag Tags::Arial                 = Tag::create("Arial");
-    
-    const sTag Tags::bang                  = Tag::create("bang");
-    const sTag Tags::bdcolor               = Tag::create("bdcolor");
-    const sTag Tags::bgcolor               = Tag::create("bgcolor");
-    const sTag Tags::bold                  = Tag::create("bold");
-    const sTag Tags::bold_italic           = Tag::create("bold italic");
-    
-    const sTag Tags::center                = Tag::create("center");
-    const sTag Tags::color                 = Tag::create("color");
-    const sTag Tags::Color                 = Tag::create("Color");
-    const sTag Tags::command               = Tag::create("command");
-    const sTag Tags::circlecolor           = Tag::create("circlecolor");
-    
-    const sTag Tags::dsp                   = Tag::create("dsp");
-    
-    const sTag Tags::from                  = Tag::create("from");
-    const sTag Tags::focus                 = Tag::create("focus");
-    const sTag Tags::font                  = Tag::create("font");
-    const sTag Tags::Font                  = Tag::create("Font");
-    const sTag Tags::Font_Face             = Tag::create("Font Face");
-    const sTag Tags::Font_Justification    = Tag::create("Font Justification");
-    const sTag Tags::Font_Name             = Tag::create("Font Name");
-    const sTag Tags::Font_Size             = Tag::create("Font Size");
-    const sTag Tags::fontface              = Tag::create("fontface");
-    const sTag Tags::fontjustification     = Tag::create("fontjustification");
-    const sTag Tags::fontname              = Tag::create("fontname");
-    const sTag Tags::fontsize              = Tag::create("fontsize");
-    
-    const sTag Tags::gridsize              = Tag::create("gridsize");
-    const sTag Tags::hidden                = Tag::create("hidden");
-    
-    const sTag Tags::id                    = Tag::create("id");
-    const sTag Tags::ignoreclick           = Tag::create("ignoreclick");
-    const sTag Tags::italic                = Tag::create("italic");
-    
-    const sTag Tags::ledcolor              = Tag::create("ledcolor");
-    const sTag Tags::left                  = Tag::create("left");
-    const sTag Tags::link                  = Tag::create("link");
-    const sTag Tags::links                 = Tag::create("links");
-    const sTag Tags::locked_bgcolor        = Tag::create("locked_bgcolor");
-    
-    const sTag Tags::Menelo                = Tag::create("Menelo");
-    const sTag Tags::mescolor              = Tag::create("mescolor");
-    const sTag Tags::Message_Color         = Tag::create("Message Color");
-    
-    const sTag Tags::name                  = Tag::create("name");
-    const sTag Tags::newlink               = Tag::create("newlink");
-    const sTag Tags::newobject             = Tag::create("newobject");
-    const sTag Tags::ninlets               = Tag::create("ninlets");
-    const sTag Tags::normal                = Tag::create("normal");
-    const sTag Tags::noutlets              = Tag::create("noutlets");
-    
-    const sTag Tags::object                = Tag::create("object");
-    const sTag Tags::objects               = Tag::create("objects");
-    
-    const sTag Tags::patcher               = Tag::create("patcher");
-    const sTag Tags::position              = Tag::create("position");
-    const sTag Tags::presentation          = Tag::create("presentation");
-    const sTag Tags::presentation_position = Tag::create("presentation_position");
-    const sTag Tags::presentation_size     = Tag::create("presentation_size");
-    
-    const sTag Tags::removelink            = Tag::create("removelink");
-    const sTag Tags::removeobject          = Tag::create("removeobject");
-    const sTag Tags::right                 = Tag::create("right");
-    
-    const sTag Tags::set                   = Tag::create("set");
-    const sTag Tags::sigcolor              = Tag::create("sigcolor");
-    const sTag Tags::Signal_Color          = Tag::create("Signal Color");
-    const sTag Tags::size                  = Tag::create("size");
-    
-    const sTag Tags::text                  = Tag::create("text");
-    const sTag Tags::textcolor             = Tag::create("textcolor");
-    const sTag Tags::to                    = Tag::create("to");
-    
-    const sTag Tags::unlocked_bgcolor      = Tag::create("unlocked_bgcolor");
+    //! Checks if a tag matchs to a string.
+    static inline bool match(const Tag* tag, const ulong hash, char const* data, const size_t size) noexcept
+    {
+        return tag->getHash() == hash && tag->getName().size() == size && !memcmp(tag->getName().data(), data, size);
+    }
+    
+    // ================================================================================ //
+    //                                      TAG CACHE                                   //
+    // ================================================================================ //
+    
+    //! The cache of the tags of a thread.
+    /** The cache is a direct-mapped table owned by a thread that retains the last pinned tags retrieved by the thread. The pinned tags are never deleted so the entries never need to be invalidated, a collision simply replaces the entry. The reclaimable tags are never cached.
+     */
+    class Tag::Cache
+    {
+    private:
+        static const ulong size = 512ul;
+        
+        const Tag*      m_entries[size];
+        ulong           m_hits;
+        ulong           m_misses;
+        
+        static thread_local Cache m_cache;
+        
+    public:
+        
+        //! Looks for a tag in the cache of the current thread.
+        static inline const Tag* find(const ulong hash, char const* data, const size_t size) noexcept
+        {
+            const Tag* tag = m_cache.m_entries[(hash >> 7) % Cache::size];
+            if(tag && match(tag, hash, data, size))
+            {
+                m_cache.m_hits++;
+                return tag;
+            }
+            m_cache.m_misses++;
+            return nullptr;
+        }
+        
+        //! Stores a pinned tag in the cache of the current thread.
+        static inline void store(const ulong hash, const Tag* tag) noexcept
+        {
+            m_cache.m_entries[(hash >> 7) % Cache::size] = tag;
+        }
+        
+        static inline ulong hits() noexcept {return m_cache.m_hits;}
+        
+        static inline ulong misses() noexcept {return m_cache.m_misses;}
+        
+        static inline void reset() noexcept {m_cache.m_hits = m_cache.m_misses = 0ul;}
+    };
+    
+    thread_local Tag::Cache Tag::Cache::m_cache;
+    
+    // ================================================================================ //
+    //                                      TAG POOL                                    //
+    // ================================================================================ //
+    
+    //! The pool owns the tags.
+    /** The pool is splitted in shards selected by the hash of the name, each shard is an open-addressed table that can be read without locking. Only the insertion or the removal of a tag locks the mutex of its shard. A reader can still walk through a tag or a slot array after its removal, so the memory is retired and only freed when all the readers that could have seen it are gone.
+     */
+    class Tag::Pool
+    {
+    private:
+        static const ulong nshards = 64ul;
+        
+        // ================================================================================ //
+        //                                      EPOCH                                       //
+        // ================================================================================ //
+        
+        //! The epoch defers the deletion of the memory that can still be read without locking.
+        /** Each reader announces the global epoch before walking through the pool. Memory retired during an epoch is freed once every active reader has announced a later epoch.
+         */
+        class Epoch
+        {
+        private:
+            class Record
+            {
+            public:
+                atomic<ulong>   epoch;
+                atomic<bool>    used;
+                Record*         next;
+                
+                inline Record(Record* _next) noexcept : epoch(0ul), used(true), next(_next) {}
+            };
+            
+            class Owner
+            {
+            public:
+                Record* record = nullptr;
+                inline ~Owner() noexcept {if(record) {record->used.store(false, memory_order_release);}}
+            };
+            
+            class Retired
+            {
+            public:
+                ulong   epoch;
+                void*   ptr;
+                void  (*free)(void*);
+            };
+            
+            atomic<ulong>       m_epoch;
+            atomic<Record*>     m_records;
+            vector<Retired>     m_retired;
+            mutex               m_mutex;
+            
+            static thread_local Owner m_owner;
+            
+            //! Retrieves the record of the current thread.
+            inline Record* record() noexcept
+            {
+                if(!m_owner.record)
+                {
+                    for(Record* r = m_records.load(memory_order_acquire); r; r = r->next)
+                    {
+                        bool used = false;
+                        if(r->used.compare_exchange_strong(used, true, memory_order_acq_rel))
+                        {
+                            return m_owner.record = r;
+                        }
+                    }
+                    Record* r = new Record(m_records.load(memory_order_relaxed));
+                    while(!m_records.compare_exchange_weak(r->next, r, memory_order_acq_rel)) {}
+                    m_owner.record = r;
+                }
+                return m_owner.record;
+            }
+            
+            //! Frees the memory that can't be read anymore, the mutex must be locked.
+            void collect() noexcept
+            {
+                const ulong epoch = m_epoch.fetch_add(1ul, memory_order_seq_cst) + 1ul;
+                ulong oldest = epoch;
+                for(Record* r = m_records.load(memory_order_acquire); r; r = r->next)
+                {
+                    const ulong e = r->epoch.load(memory_order_seq_cst);
+                    if(e && e < oldest)
+                    {
+                        oldest = e;
+                    }
+                }
+                
+                auto it = partition(m_retired.begin(), m_retired.end(), [oldest](Retired const& r) {return r.epoch >= oldest;});
+                for(auto it2 = it; it2 != m_retired.end(); ++it2)
+                {
+                    it2->free(it2->ptr);
+                }
+                m_retired.erase(it, m_retired.end());
+            }
+            
+        public:
+            
+            //! The guard must be held by a reader that walks through the pool without locking.
+            class Guard
+            {
+            private:
+                Record* const m_record;
+            public:
+                inline Guard(Epoch& epoch) noexcept : m_record(epoch.record())
+                {
+                    m_record->epoch.store(epoch.m_epoch.load(memory_order_seq_cst), memory_order_seq_cst);
+                    atomic_thread_fence(memory_order_seq_cst);
+                }
+                
+                inline ~Guard() noexcept
+                {
+                    m_record->epoch.store(0ul, memory_order_release);
+                }
+            };
+            
+            inline Epoch() noexcept : m_epoch(1ul), m_records(nullptr) {}
+            
+            inline ~Epoch() noexcept
+            {
+                for(auto const& it : m_retired)
+                {
+                    it.free(it.ptr);
+                }
+                Record* r = m_records.load(memory_order_relaxed);
+                while(r)
+                {
+                    Record* next = r->next;
+                    delete r;
+                    r = next;
+                }
+            }
+            
+            //! Retires a pointer that has already been removed from the pool.
+            template <class T> void retire(T* ptr) noexcept
+            {
+                atomic_thread_fence(memory_order_seq_cst);
+                lock_guard<mutex> guard(m_mutex);
+                m_retired.push_back({m_epoch.load(memory_order_seq_cst), (void*)ptr, [](void* p) {delete (T*)p;}});
+                if(m_retired.size() >= 1024ul)
+                {
+                    collect();
+                }
+            }
+            
+            //! Frees the memory that can't be read anymore.
+            inline void reclaim() noexcept
+            {
+                lock_guard<mutex> guard(m_mutex);
+                collect();
+            }
+        };
+        
+        // ================================================================================ //
+        //                                      SHARD                                       //
+        // ================================================================================ //
+        
+        class Slots
+        {
+        public:
+            const ulong                                 mask;
+            const unique_ptr<atomic<const Tag*>[]>      slots;
+            
+            inline Slots(const ulong size) noexcept : mask(size - 1ul), slots(new atomic<const Tag*>[size])
+            {
+                for(ulong i = 0; i <= mask; i++)
+                {
+                    slots[i].store(nullptr, memory_order_relaxed);
+                }
+            }
+        };
+        
+        class Shard
+        {
+        public:
+            atomic<Slots*>          m_slots;
+            ulong                   m_size;
+            ulong                   m_removed;
+            mutex                   m_mutex;
+            
+            inline Shard() noexcept : m_slots(new Slots(16ul)), m_size(0ul), m_removed(0ul) {}
+            
+            //! Deletes the pinned tags, the reclaimable tags are deleted by their last pointer.
+            inline ~Shard() noexcept
+            {
+                Slots* slots = m_slots.load(memory_order_relaxed);
+                for(ulong i = 0; i <= slots->mask; i++)
+                {
+                    const Tag* tag = slots->slots[i].load(memory_order_relaxed);
+                    if(tag && tag != removed() && !tag->m_reclaimable.load(memory_order_relaxed))
+                    {
+                        delete tag;
+                    }
+                }
+                delete slots;
+            }
+            
+            //! The marker of a removed tag.
+            static inline const Tag* removed() noexcept
+            {
+                static const Tag marker(string_view{});
+                return &marker;
+            }
+            
+            //! Looks for a tag in a slot array without locking, the tag is matched once so a concurrent removal can't be observed.
+            static inline const Tag* lookup(Slots const* slots, const ulong hash, char const* data, const size_t size) noexcept
+            {
+                for(ulong i = probe(hash) & slots->mask;; i = (i + 1ul) & slots->mask)
+                {
+                    const Tag* tag = slots->slots[i].load(memory_order_acquire);
+                    if(!tag)
+                    {
+                        return nullptr;
+                    }
+                    else if(tag != removed() && match(tag, hash, data, size))
+                    {
+                        return tag;
+                    }
+                }
+            }
+            
+            //! Looks for the slot of a tag in a slot array, the mutex must be locked.
+            static inline atomic<const Tag*>* find(Slots const* slots, const ulong hash, char const* data, const size_t size) noexcept
+            {
+                for(ulong i = probe(hash) & slots->mask;; i = (i + 1ul) & slots->mask)
+                {
+                    const Tag* tag = slots->slots[i].load(memory_order_acquire);
+                    if(!tag)
+                    {
+                        return nullptr;
+                    }
+                    else if(tag != removed() && match(tag, hash, data, size))
+                    {
+                        return &slots->slots[i];
+                    }
+                }
+            }
+            
+            //! Inserts a tag in a slot array, the slot array must have a free slot.
+            static inline void insert(Slots* slots, const Tag* tag) noexcept
+            {
+                ulong i = probe(tag->m_hash) & slots->mask;
+                while(slots->slots[i].load(memory_order_relaxed))
+                {
+                    i = (i + 1ul) & slots->mask;
+                }
+                slots->slots[i].store(tag, memory_order_release);
+            }
+            
+            //! Removes a tag from its slot, the mutex must be locked.
+            inline void remove(atomic<const Tag*>& slot) noexcept
+            {
+                slot.store(removed(), memory_order_release);
+                m_size--;
+                m_removed++;
+            }
+            
+            //! Ensures that a number of tags can be inserted, the mutex must be locked.
+            Slots* reserve(const ulong count, Pool& pool) noexcept
+            {
+                // The shard is rebuilt when it's three-quarters full
+                Slots* slots = m_slots.load(memory_order_relaxed);
+                if((m_size + m_removed + count) * 4ul > (slots->mask + 1ul) * 3ul)
+                {
+                    ulong size = 16ul;
+                    while((m_size + count) * 2ul > size)
+                    {
+                        size *= 2ul;
+                    }
+                    Slots* nslots = new Slots(size);
+                    for(ulong i = 0; i <= slots->mask; i++)
+                    {
+                        const Tag* tag = slots->slots[i].load(memory_order_relaxed);
+                        if(tag && tag != removed())
+                        {
+                            insert(nslots, tag);
+                        }
+                    }
+                    m_slots.store(nslots, memory_order_release);
+                    pool.m_epoch.retire(slots);
+                    m_removed = 0ul;
+                    slots = nslots;
+                }
+                return slots;
+            }
+            
+            //! Creates the pinned tags of an image that don't exist yet.
+            ulong insert(vector<Image::Record> const& records, char const* names, Pool& pool) noexcept
+            {
+                ulong count = 0ul;
+                lock_guard<mutex> guard(m_mutex);
+                Slots* slots = reserve(records.size(), pool);
+                for(auto const& record : records)
+                {
+                    char const* name = names + record.offset;
+                    atomic<const Tag*>* slot = find(slots, record.hash, name, record.size);
+                    if(slot)
+                    {
+                        const Tag* tag = slot->load(memory_order_relaxed);
+                        if(!tag->m_reclaimable.load(memory_order_relaxed) || acquire(tag))
+                        {
+                            // The tag is pinned, its reference is ignored from now
+                            tag->m_reclaimable.store(false, memory_order_relaxed);
+                            continue;
+                        }
+                        remove(*slot);
+                    }
+                    insert(slots, new Tag(string_view(name, record.size), ulong(record.hash), pool.m_ids.fetch_add(1ul, memory_order_relaxed)));
+                    m_size++;
+                    count++;
+                }
+                return count;
+            }
+            
+            //! Retrieves the pinned tags.
+            void pinned(vector<const Tag*>& tags) noexcept
+            {
+                lock_guard<mutex> guard(m_mutex);
+                Slots* slots = m_slots.load(memory_order_relaxed);
+                for(ulong i = 0; i <= slots->mask; i++)
+                {
+                    const Tag* tag = slots->slots[i].load(memory_order_relaxed);
+                    if(tag && tag != removed() && !tag->m_reclaimable.load(memory_order_relaxed))
+                    {
+                        tags.push_back(tag);
+                    }
+                }
+            }
+            
+            //! Retrieves a tag or creates it.
+            template <class T> sTag create(T&& name, const ulong hash, const bool pinned, Pool& pool) noexcept
+            {
+                lock_guard<mutex> guard(m_mutex);
+                Slots* slots = m_slots.load(memory_order_relaxed);
+                atomic<const Tag*>* slot = find(slots, hash, name.data(), name.size());
+                if(slot)
+                {
+                    const Tag* tag = slot->load(memory_order_relaxed);
+                    if(!tag->m_reclaimable.load(memory_order_relaxed))
+                    {
+                        return sTag(tag, true);
+                    }
+                    else if(acquire(tag))
+                    {
+                        // From now the tag is owned by the pool, the reference counter is ignored
+                        if(pinned)
+                        {
+                            tag->m_reclaimable.store(false, memory_order_relaxed);
+                        }
+                        return sTag(tag, true);
+                    }
+                    
+                    // The tag is dying, it will be deleted by its last pointer
+                    remove(*slot);
+                }
+                
+                slots = reserve(1ul, pool);
+                Tag* tag = new Tag(forward<T>(name), hash, pool.m_ids.fetch_add(1ul, memory_order_relaxed));
+                if(!pinned)
+                {
+                    tag->m_refs.store(1ul, memory_order_relaxed);
+                    tag->m_reclaimable.store(true, memory_order_relaxed);
+                }
+                insert(slots, tag);
+                m_size++;
+                return sTag(tag, true);
+            }
+            
+            //! Removes a tag that isn't used anymore.
+            inline void release(const Tag* tag, Epoch& epoch) noexcept
+            {
+                lock_guard<mutex> guard(m_mutex);
+                
+                // The tag has been pinned after the release of its last reference
+                if(!tag->m_reclaimable.load(memory_order_relaxed))
+                {
+                    return;
+                }
+                
+                Slots* slots = m_slots.load(memory_order_relaxed);
+                for(ulong i = probe(tag->m_hash) & slots->mask;; i = (i + 1ul) & slots->mask)
+                {
+                    const Tag* current = slots->slots[i].load(memory_order_relaxed);
+                    if(!current)
+                    {
+                        break;
+                    }
+                    else if(current == tag)
+                    {
+                        remove(slots->slots[i]);
+                        break;
+                    }
+                }
+                epoch.retire(const_cast<Tag*>(tag));
+            }
+        };
+        
+        //! Increments the reference counter of a reclaimable tag if it isn't dying.
+        static inline bool acquire(const Tag* tag) noexcept
+        {
+            ulong refs = tag->m_refs.load(memory_order_relaxed);
+            while(refs)
+            {
+                if(tag->m_refs.compare_exchange_weak(refs, refs + 1ul, memory_order_acquire, memory_order_relaxed))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        Epoch           m_epoch;
+        atomic<bool>    m_alive;
+        Shard           m_shards[nshards];
+        atomic<ulong>   m_ids;
+        atomic<bool>    m_reclaiming;
+        
+        //! Mixes the hash to select a slot, the lower bits are used to select the shard.
+        static inline ulong probe(const ulong hash) noexcept
+        {
+            ulong h = hash / nshards;
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdul;
+            h ^= h >> 33;
+            return h;
+        }
+        
+    public:
+        
+        inline Pool() noexcept : m_alive(true), m_ids(0ul), m_reclaiming(false) {}
+        
+        inline ~Pool() noexcept {m_alive.store(false, memory_order_release);}
+        
+        inline ulong size() const noexcept {return m_ids.load(memory_order_relaxed);}
+        
+        inline bool isReclaiming() const noexcept {return m_reclaiming.load(memory_order_relaxed);}
+        
+        inline void setReclaiming(const bool state) noexcept {m_reclaiming.store(state, memory_order_relaxed);}
+        
+        inline void collect() noexcept {m_epoch.reclaim();}
+        
+        template <class T> inline sTag create(T&& name, const ulong hash, const bool pinned) noexcept
+        {
+            const Tag* tag = Cache::find(hash, name.data(), name.size());
+            if(tag)
+            {
+                return sTag(tag, true);
+            }
+            
+            Shard& shard = m_shards[hash % nshards];
+            {
+                Epoch::Guard guard(m_epoch);
+                tag = Shard::lookup(shard.m_slots.load(memory_order_acquire), hash, name.data(), name.size());
+                if(tag)
+                {
+                    if(!tag->m_reclaimable.load(memory_order_relaxed))
+                    {
+                        Cache::store(hash, tag);
+                        return sTag(tag, true);
+                    }
+                    else if(!pinned && acquire(tag))
+                    {
+                        return sTag(tag, true);
+                    }
+                }
+            }
+            
+            sTag result = shard.create(forward<T>(name), hash, pinned || !isReclaiming(), *this);
+            if(!result->m_reclaimable.load(memory_order_relaxed))
+            {
+                Cache::store(hash, result.get());
+            }
+            return result;
+        }
+        
+        //! Creates the pinned tags of an image that don't exist yet, the records are read from a buffer that can be unaligned.
+        ulong insert(char const* records, const ulong size, char const* names) noexcept
+        {
+            vector<vector<Image::Record>> shards(nshards);
+            for(ulong i = 0; i < size; i++)
+            {
+                Image::Record record;
+                memcpy(&record, records + i * sizeof(Image::Record), sizeof(Image::Record));
+                shards[record.hash % nshards].push_back(record);
+            }
+            
+            ulong count = 0ul;
+            for(ulong i = 0; i < nshards; i++)
+            {
+                if(!shards[i].empty())
+                {
+                    count += m_shards[i].insert(shards[i], names, *this);
+                }
+            }
+            return count;
+        }
+        
+        //! Retrieves the pinned tags in the order of their ids.
+        vector<const Tag*> pinned() noexcept
+        {
+            vector<const Tag*> tags;
+            for(ulong i = 0; i < nshards; i++)
+            {
+                m_shards[i].pinned(tags);
+            }
+            sort(tags.begin(), tags.end(), [](const Tag* t1, const Tag* t2) {return t1->m_id < t2->m_id;});
+            return tags;
+        }
+        
+        //! Removes a tag that isn't used anymore.
+        inline void release(const Tag* tag) noexcept
+        {
+            if(!m_alive.load(memory_order_acquire))
+            {
+                delete tag;
+                return;
+            }
+            m_shards[tag->m_hash % nshards].release(tag, m_epoch);
+        }
+    };
+    
+    thread_local Tag::Pool::Epoch::Owner Tag::Pool::Epoch::m_owner;
+    
+    void Tag::reclaim(const Tag* tag) noexcept
+    {
+        getPool().release(tag);
+    }
+    
+    Tag::Pool& Tag::getPool() noexcept
+    {
+        static Pool pool;
+        return pool;
+    }
+    
+    ulong Tag::getCacheHits() noexcept
+    {
+        return Cache::hits();
+    }
+    
+    ulong Tag::getCacheMisses() noexcept
+    {
+        return Cache::misses();
+    }
+    
+    void Tag::resetCacheStatistics() noexcept
+    {
+        Cache::reset();
+    }
+    
+    ulong Tag::getNumberOfTags() noexcept
+    {
+        return getPool().size();
+    }
+    
+    bool Tag::isReclaiming() noexcept
+    {
+        return getPool().isReclaiming();
+    }
+    
+    void Tag::setReclaiming(const bool state) noexcept
+    {
+        getPool().setReclaiming(state);
+    }
+    
+    void Tag::collect() noexcept
+    {
+        getPool().collect();
+    }
+    
+    sTag Tag::create(string const& name) noexcept
+    {
+        return getPool().create(name, hash(name.data(), name.size()), false);
+    }
+    
+    sTag Tag::create(string&& name) noexcept
+    {
+        const ulong h = hash(name.data(), name.size());
+        return getPool().create(forward<string>(name), h, false);
+    }
+    
+    sTag Tag::create(string_view name) noexcept
+    {
+        return getPool().create(name, hash(name.data(), name.size()), false);
+    }
+    
+    sTag Tag::create(Literal const& literal) noexcept
+    {
+        return getPool().create(literal.name, literal.hash, true);
+    }
+    
+    sTag Tag::pin(string_view name) noexcept
+    {
+        return getPool().create(name, hash(name.data(), name.size()), true);
+    }
+    
+    // ================================================================================ //
+    //                                      TAG IMAGE                                   //
+    // ================================================================================ //
+    
+    // The serialized image is a header followed by the records and the names
+    static const char       image_magic[4] = {'K', 'T', 'A', 'G'};
+    static const uint32_t   image_version  = 1u;
+    static const size_t     image_header   = 24ul;
+    
+    Tag::Image Tag::Image::fromPool()
+    {
+        Image image;
+        for(auto tag : getPool().pinned())
+        {
+            image.add(tag->getName());
+        }
+        return image;
+    }
+    
+    void Tag::Image::add(string_view name)
+    {
+        m_records.push_back({Tag::hash(name.data(), name.size()), uint32_t(m_names.size()), uint32_t(name.size())});
+        m_names.append(name.data(), name.size());
+    }
+    
+    string Tag::Image::data() const
+    {
+        const uint64_t nrecords = m_records.size();
+        const uint64_t nnames   = m_names.size();
+        string data(image_header, '\0');
+        memcpy(&data[0], image_magic, 4ul);
+        memcpy(&data[4], &image_version, 4ul);
+        memcpy(&data[8], &nrecords, 8ul);
+        memcpy(&data[16], &nnames, 8ul);
+        data.append((char const*)m_records.data(), m_records.size() * sizeof(Record));
+        data.append(m_names);
+        return data;
+    }
+    
+    bool Tag::Image::write(string const& path) const
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        if(file.is_open())
+        {
+            const string bytes = data();
+            file.write(bytes.data(), streamsize(bytes.size()));
+            return bool(file);
+        }
+        return false;
+    }
+    
+    ulong Tag::Image::insert() const noexcept
+    {
+        return getPool().insert((char const*)m_records.data(), m_records.size(), m_names.data());
+    }
+    
+    ulong Tag::Image::load(const void* data, const size_t size) noexcept
+    {
+        char const* bytes = (char const*)data;
+        uint32_t version;
+        uint64_t nrecords, nnames;
+        if(size < image_header || memcmp(bytes, image_magic, 4ul))
+        {
+            return 0ul;
+        }
+        memcpy(&version, bytes + 4, 4ul);
+        memcpy(&nrecords, bytes + 8, 8ul);
+        memcpy(&nnames, bytes + 16, 8ul);
+        if(version != image_version || nrecords > (size - image_header) / sizeof(Record) || nnames != size - image_header - nrecords * sizeof(Record))
+        {
+            return 0ul;
+        }
+        
+        char const* records = bytes + image_header;
+        char const* names   = records + nrecords * sizeof(Record);
+        for(uint64_t i = 0; i < nrecords; i++)
+        {
+            Record record;
+            memcpy(&record, records + i * sizeof(Record), sizeof(Record));
+            if(uint64_t(record.offset) + uint64_t(record.size) > nnames || record.hash != Tag::hash(names + record.offset, record.size))
+            {
+                return 0ul;
+            }
+        }
+        return getPool().insert(records, ulong(nrecords), names);
+    }
+    
+    ulong Tag::Image::read(string const& path) noexcept
+    {
+        ifstream file(path, ios::binary | ios::ate);
+        if(file.is_open())
+        {
+            string bytes(size_t(file.tellg()), '\0');
+            file.seekg(0);
+            if(file.read(&bytes[0], streamsize(bytes.size())))
+            {
+                return load(bytes.data(), bytes.size());
+            }
+        }
+        return 0ul;
+    }
+    
+    // ================================================================================ //
+    //                                      TAGS                                        //
+    // ================================================================================ //
+    
+    // The literals are constexpr variables so the hashes are computed at compile time and not by the dynamic initialization of the tags
+    #define KIWI_DEFINE_TAG(tag, literal) \
+    static constexpr Tag::Literal tag##_literal(literal);\
+    const sTag Tags::tag = Tag::create(tag##_literal)
+    
+    KIWI_DEFINE_TAG(_empty,                 "");
+    KIWI_DEFINE_TAG(arguments,              "arguments");
+    KIWI_DEFINE_TAG(Arial,                  "Arial");
+    
+    KIWI_DEFINE_TAG(bang,                   "bang");
+    KIWI_DEFINE_TAG(bdcolor,                "bdcolor");
+    KIWI_DEFINE_TAG(bgcolor,                "bgcolor");
+    KIWI_DEFINE_TAG(bold,                   "bold");
+    KIWI_DEFINE_TAG(bold_italic,            "bold italic");
+    
+    KIWI_DEFINE_TAG(center,                 "center");
+    KIWI_DEFINE_TAG(color,                  "color");
+    KIWI_DEFINE_TAG(Color,                  "Color");
+    KIWI_DEFINE_TAG(command,                "command");
+    KIWI_DEFINE_TAG(circlecolor,            "circlecolor");
+    
+    KIWI_DEFINE_TAG(dsp,                    "dsp");
+    
+    KIWI_DEFINE_TAG(from,                   "from");
+    KIWI_DEFINE_TAG(focus,                  "focus");
+    KIWI_DEFINE_TAG(font,                   "font");
+    KIWI_DEFINE_TAG(Font,                   "Font");
+    KIWI_DEFINE_TAG(Font_Face,              "Font Face");
+    KIWI_DEFINE_TAG(Font_Justification,     "Font Justification");
+    KIWI_DEFINE_TAG(Font_Name,              "Font Name");
+    KIWI_DEFINE_TAG(Font_Size,              "Font Size");
+    KIWI_DEFINE_TAG(fontface,               "fontface");
+    KIWI_DEFINE_TAG(fontjustification,      "fontjustification");
+    KIWI_DEFINE_TAG(fontname,               "fontname");
+    KIWI_DEFINE_TAG(fontsize,               "fontsize");
+    
+    KIWI_DEFINE_TAG(gridsize,               "gridsize");
+    KIWI_DEFINE_TAG(hidden,                 "hidden");
+    
+    KIWI_DEFINE_TAG(id,                     "id");
+    KIWI_DEFINE_TAG(ignoreclick,            "ignoreclick");
+    KIWI_DEFINE_TAG(italic,                 "italic");
+    
+    KIWI_DEFINE_TAG(ledcolor,               "ledcolor");
+    KIWI_DEFINE_TAG(left,                   "left");
+    KIWI_DEFINE_TAG(link,                   "link");
+    KIWI_DEFINE_TAG(links,                  "links");
+    KIWI_DEFINE_TAG(locked_bgcolor,         "locked_bgcolor");
+    
+    KIWI_DEFINE_TAG(Menelo,                 "Menelo");
+    KIWI_DEFINE_TAG(mescolor,               "mescolor");
+    KIWI_DEFINE_TAG(Message_Color,          "Message Color");
+    
+    KIWI_DEFINE_TAG(name,                   "name");
+    KIWI_DEFINE_TAG(newlink,                "newlink");
+    KIWI_DEFINE_TAG(newobject,              "newobject");
+    KIWI_DEFINE_TAG(ninlets,                "ninlets");
+    KIWI_DEFINE_TAG(normal,                 "normal");
+    KIWI_DEFINE_TAG(noutlets,               "noutlets");
+    
+    KIWI_DEFINE_TAG(object,                 "object");
+    KIWI_DEFINE_TAG(objects,                "objects");
+    
+    KIWI_DEFINE_TAG(patcher,                "patcher");
+    KIWI_DEFINE_TAG(position,               "position");
+    KIWI_DEFINE_TAG(presentation,           "presentation");
+    KIWI_DEFINE_TAG(presentation_position,  "presentation_position");
+    KIWI_DEFINE_TAG(presentation_size,      "presentation_size");
+    
+    KIWI_DEFINE_TAG(removelink,             "removelink");
+    KIWI_DEFINE_TAG(removeobject,           "removeobject");
+    KIWI_DEFINE_TAG(right,                  "right");
+    
+    KIWI_DEFINE_TAG(set,                    "set");
+    KIWI_DEFINE_TAG(sigcolor,               "sigcolor");
+    KIWI_DEFINE_TAG(Signal_Color,           "Signal Color");
+    KIWI_DEFINE_TAG(size,                   "size");
+    
+    KIWI_DEFINE_TAG(text,                   "text");
+    KIWI_DEFINE_TAG(textcolor,              "textcolor");
+    KIWI_DEFINE_TAG(to,                     "to");
+    
+    KIWI_DEFINE_TAG(unlocked_bgcolor,       "unlocked_bgcolor");
+    
+    #undef KIWI_DEFINE_TAG
 }
 
 
@@ -40,18 +40,61 @@ namespace Kiwi
     class Tag
     {
     private:
-        const string m_name;
+        friend class TagPtr;
+        
+        const string                m_name;
+        const ulong                 m_hash;
+        const ulong                 m_id;
+        mutable atomic<ulong>       m_refs;
+        mutable atomic<bool>        m_reclaimable;
+        
+        //! Increments the reference counter of a reclaimable tag.
+        inline void retain() const noexcept
+        {
+            if(m_reclaimable.load(memory_order_relaxed))
+            {
+                m_refs.fetch_add(1ul, memory_order_relaxed);
+            }
+        }
+        
+        //! Decrements the reference counter of a reclaimable tag and removes the tag from the pool if it isn't used anymore.
+        inline void release() const noexcept
+        {
+            if(m_reclaimable.load(memory_order_relaxed) && m_refs.fetch_sub(1ul, memory_order_acq_rel) == 1ul)
+            {
+                reclaim(this);
+            }
+        }
+        
+        //! Removes a tag that isn't used anymore from the pool.
+        static void reclaim(const Tag* tag) noexcept;
+        
     public:
         
         //! The constructor.
         /** You should never use this method except if you really know what you do.
          */
-        inline Tag(string const& name) noexcept : m_name(name) {}
+        inline Tag(string const& name, const ulong id = 0ul) noexcept : m_name(name), m_hash(hash(name.c_str(), name.size())), m_id(id), m_refs(0ul), m_reclaimable(false) {}
+        
+        //! The constructor.
+        /** You should never use this method except if you really know what you do.
+         */
+        inline Tag(string&& name, const ulong id = 0ul) noexcept : m_name(move(name)), m_hash(hash(m_name.c_str(), m_name.size())), m_id(id), m_refs(0ul), m_reclaimable(false) {}
         
         //! The constructor.
         /** You should never use this method except if you really know what you do.
          */
-        inline Tag(string&& name) noexcept : m_name(name) {}
+        inline Tag(string_view name, const ulong id = 0ul) noexcept : m_name(name), m_hash(hash(name.data(), name.size())), m_id(id), m_refs(0ul), m_reclaimable(false) {}
+        
+        //! The constructor.
+        /** You should never use this method except if you really know what you do. The hash must be the hash of the name.
+         */
+        inline Tag(string_view name, const ulong hash, const ulong id) noexcept : m_name(name), m_hash(hash), m_id(id), m_refs(0ul), m_reclaimable(false) {}
+        
+        //! The constructor.
+        /** You should never use this method except if you really know what you do. The hash must be the hash of the name.
+         */
+        inline Tag(string&& name, const ulong hash, const ulong id) noexcept : m_name(move(name)), m_hash(hash), m_id(id), m_refs(0ul), m_reclaimable(false) {}
         
         //! The destructor.
         /** You should never use this method except if you really know what you do.
@@ -59,63 +102,386 @@ namespace Kiwi
         inline ~Tag() noexcept {}
         
         //! Retrieve the string of the tag.
-        /** The function retrieves the unique string of the tag.
+        /** The function retrieves the unique string of the tag. The string lives as long as the tag, so you don't need to copy it.
          @return The string of the tag.
          */
-        inline string getName() const noexcept { return m_name; }
+        inline string const& getName() const noexcept { return m_name; }
+        
+        //! Retrieve the hash of the tag.
+        /** The function retrieves the hash of the string of the tag.
+         @return The hash of the tag.
+         */
+        inline ulong getHash() const noexcept { return m_hash; }
+        
+        //! Retrieve the id of the tag.
+        /** The function retrieves the id of the tag. The ids are given in the order of creation of the tags, starting from zero, so they can be used to index an array.
+         @return The id of the tag.
+         @see TagMap
+         */
+        inline ulong getId() const noexcept { return m_id; }
+        
+        //! Retrieve the number of tags.
+        /** The function retrieves the number of tags that have been created, it's also the next id that will be given. The ids of the deleted tags are never given again.
+         @return The number of tags.
+         */
+        static ulong getNumberOfTags() noexcept;
+        
+        //! Compute the hash of a string.
+        /** The function computes the FNV-1a hash of a string, it's the hash used by the tag pool.
+         @param  data   The characters of the string.
+         @param  size   The number of characters.
+         @return    The hash of the string.
+         */
+        static constexpr ulong hash(char const* data, const size_t size) noexcept
+        {
+            ulong h = 14695981039346656037ul;
+            for(size_t i = 0; i < size; i++)
+            {
+                h ^= (unsigned char)data[i];
+                h *= 1099511628211ul;
+            }
+            return h;
+        }
+    
+        //! The tag literal.
+        /** The literal is a name whose hash is computed at compile time, it should be created with a string literal.
+         @see KIWI_TAG
+         */
+        class Literal
+        {
+        public:
+            const string_view name;
+            const ulong       hash;
+            
+            constexpr Literal(string_view _name) noexcept : name(_name), hash(Tag::hash(_name.data(), _name.size())) {}
+        };
     
     private:
         
-        static map<string, sTag> m_tags;
-        static mutex             m_mutex;
+        class Pool;
+        class Cache;
+        
+        //! Retrieve the pool of tags.
+        /** The pool is created the first time it is used, so tags can be created during the static initialization.
+         */
+        static Pool& getPool() noexcept;
 
     public:
         
         //! Tag creator.
-        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name.
+        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name. The function first looks in the cache of the current thread, then the lookup of an existing tag in the pool doesn't lock, only the creation of a new tag locks one shard of the pool.
          @param  name   The name of the tag to retrieve.
          @return    The tag that match with the name.
          */
-        static inline sTag create(string const& name) noexcept
+        static sTag create(string const& name) noexcept;
+        
+        //! Tag creator.
+        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name. The function first looks in the cache of the current thread, then the lookup of an existing tag in the pool doesn't lock, only the creation of a new tag locks one shard of the pool.
+         @param  name   The name of the tag to retrieve.
+         @return    The tag that match with the name.
+         */
+        static sTag create(string&& name) noexcept;
+        
+        //! Tag creator.
+        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name. The function doesn't allocate anything if the tag already exists, so you can use it on a slice of a larger buffer.
+         @param  name   The name of the tag to retrieve.
+         @return    The tag that match with the name.
+         */
+        static sTag create(string_view name) noexcept;
+        
+        //! Tag creator.
+        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name. The function doesn't allocate anything if the tag already exists.
+         @param  name   The name of the tag to retrieve.
+         @return    The tag that match with the name.
+         */
+        static inline sTag create(char const* name) noexcept;
+        
+        //! Tag creator.
+        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name. The hash of the literal has already been computed so the function directly looks in the pool. You should prefer KIWI_TAG that only calls this function once.
+         @param  literal   The literal of the tag to retrieve.
+         @return    The tag that match with the literal.
+         @see KIWI_TAG
+         */
+        static sTag create(Literal const& literal) noexcept;
+        
+        //! Tag creator.
+        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name. The tag is pinned, it will never be deleted even if the pool is reclaiming.
+         @param  name   The name of the tag to retrieve.
+         @return    The tag that match with the name.
+         @see setReclaiming
+         */
+        static sTag pin(string_view name) noexcept;
+        
+        //! Set if the pool reclaims the unused tags.
+        /** By default, the tags are never deleted. When the pool is reclaiming, the tags created afterwards are deleted when they're no more used, unless they are pinned. The tags of literals and the Tags constants are always pinned. The memory of the deleted tags is retired and freed later because other threads can still read it.
+         @param  state  True to reclaim the unused tags, false to keep all the new tags.
+         @see collect, pin
+         */
+        static void setReclaiming(const bool state) noexcept;
+        
+        //! Retrieve if the pool reclaims the unused tags.
+        /** The function retrieves if the pool reclaims the unused tags.
+         @return True if the pool reclaims the unused tags.
+         */
+        static bool isReclaiming() noexcept;
+        
+        //! Free the memory of the deleted tags.
+        /** The memory of the deleted tags is freed when no thread can read it anymore. The pool calls it regularly, but you can call it to release the memory earlier.
+         */
+        static void collect() noexcept;
+        
+        //! Retrieve the number of cache hits of the current thread.
+        /** The function retrieves the number of tags that have been retrieved by the current thread from its cache, without looking in the pool.
+         @return The number of cache hits.
+         */
+        static ulong getCacheHits() noexcept;
+        
+        //! Retrieve the number of cache misses of the current thread.
+        /** The function retrieves the number of tags that the current thread had to retrieve from the pool.
+         @return The number of cache misses.
+         */
+        static ulong getCacheMisses() noexcept;
+        
+        //! Reset the cache statistics of the current thread.
+        /** The function resets the numbers of cache hits and misses of the current thread.
+         */
+        static void resetCacheStatistics() noexcept;
+        
+        class Image;
+        class List;
+    };
+    
+    // ================================================================================ //
+    //                                      TAG IMAGE                                   //
+    // ================================================================================ //
+    
+    //! The tag image is a precomputed table of tags.
+    /** The tag image stores the names of a set of tags contiguously with their precomputed hashes. It can be saved in a file and inserted in the pool at startup, the tags are created shard by shard, with only one lock per shard and with the hashes of the image. The hashes of a serialized image are checked once when it's loaded, so a stale or corrupted image is rejected. The image can be inserted directly from a memory-mapped file.
+     @code
+     Tag::Image::fromPool().write("tags.bin");
+     ...
+     Tag::Image::read("tags.bin");
+     @endcode
+     */
+    class Tag::Image
+    {
+    public:
+        
+        //! The record of a tag in the image.
+        class Record
+        {
+        public:
+            uint64_t    hash;
+            uint32_t    offset;
+            uint32_t    size;
+        };
+        
+    private:
+        vector<Record>  m_records;
+        string          m_names;
+        
+    public:
+        
+        //! Constructor.
+        /** Creates an empty image.
+         */
+        inline Image() noexcept {}
+        
+        //! Destructor.
+        /** Frees the image.
+         */
+        inline ~Image() noexcept {}
+        
+        //! Retrieve an image of the pinned tags of the pool.
+        /** The function creates an image with all the pinned tags in the order of their ids.
+         @return The image.
+         */
+        static Image fromPool();
+        
+        //! Add a name to the image.
+        /** The function adds a name to the image.
+         @param name The name.
+         */
+        void add(string_view name);
+        
+        //! Retrieve the number of tags in the image.
+        /** The function retrieves the number of tags in the image.
+         @return The number of tags.
+         */
+        inline ulong size() const noexcept {return ulong(m_records.size());}
+        
+        //! Retrieve the serialized image.
+        /** The function retrieves the image as a block of bytes that can be saved.
+         @return The serialized image.
+         */
+        string data() const;
+        
+        //! Write the image in a file.
+        /** The function writes the serialized image in a file.
+         @param path The path of the file.
+         @return True if the image has been written.
+         */
+        bool write(string const& path) const;
+        
+        //! Insert the tags of the image in the pool.
+        /** The function creates the tags of the image that don't exist yet, the tags are pinned.
+         @return The number of tags created.
+         */
+        ulong insert() const noexcept;
+        
+        //! Insert the tags of a serialized image in the pool.
+        /** The function creates the tags of a serialized image that don't exist yet, the tags are pinned. The data is only read during the call, it can be a memory-mapped file. The image is rejected if the hash of a record doesn't match its name.
+         @param data The serialized image.
+         @param size The size of the serialized image.
+         @return The number of tags created, or zero if the data isn't a valid image.
+         */
+        static ulong load(const void* data, const size_t size) noexcept;
+        
+        //! Insert the tags of a file in the pool.
+        /** The function reads a serialized image from a file and creates the tags that don't exist yet, the tags are pinned.
+         @param path The path of the file.
+         @return The number of tags created, or zero if the file isn't a valid image.
+         */
+        static ulong read(string const& path) noexcept;
+    };
+    
+    // ================================================================================ //
+    //                                      TAG POINTER                                 //
+    // ================================================================================ //
+    
+    //! The tag pointer retains a tag.
+    /** The tag pointer has the size of a pointer. Most of the tags are pinned and never deleted, copying a pointer to such a tag only copies the pointer, so the threads that use the same tags never write to shared memory. Only the pointers to reclaimable tags count their references. A tag pointer can be converted from and to a shared pointer for compatibility.
+     @see Tag::setReclaiming
+     */
+    class TagPtr
+    {
+    private:
+        friend class Tag;
+        const Tag* m_tag;
+        
+        //! Creates a pointer that adopts a reference already counted.
+        inline TagPtr(const Tag* tag, const bool) noexcept : m_tag(tag) {}
+        
+    public:
+        
+        //! Constructor.
+        /** Creates a null pointer.
+         */
+        constexpr TagPtr() noexcept : m_tag(nullptr) {}
+        
+        //! Constructor.
+        /** Creates a null pointer.
+         */
+        constexpr TagPtr(nullptr_t) noexcept : m_tag(nullptr) {}
+        
+        //! Constructor.
+        /** Creates a pointer to the tag of another pointer.
+         */
+        inline TagPtr(TagPtr const& other) noexcept : m_tag(other.m_tag)
         {
-            lock_guard<mutex> guard(m_mutex);
-            auto it = m_tags.find(name);
-            if(it != m_tags.end())
+            if(m_tag)
             {
-                return it->second;
+                m_tag->retain();
             }
-            else
+        }
+        
+        //! Constructor.
+        /** Creates a pointer with the tag of another pointer.
+         */
+        inline TagPtr(TagPtr&& other) noexcept : m_tag(other.m_tag)
+        {
+            other.m_tag = nullptr;
+        }
+        
+        //! Constructor.
+        /** Creates a pointer to the tag of a shared pointer, the shared pointer must have been converted from a tag pointer.
+         */
+        inline TagPtr(shared_ptr<const Tag> const& tag) noexcept : m_tag(tag.get())
+        {
+            if(m_tag)
             {
-                sTag tag = make_shared<Tag>(name);
-                m_tags[name] = tag;
-                return tag;
+                m_tag->retain();
             }
         }
         
-        //! Tag creator.
-        /** This function checks if a tag with this name has already been created and returns it, otherwise it creates a new tag with this name.
-         @param  name   The name of the tag to retrieve.
-         @return    The tag that match with the name.
+        //! Destructor.
+        /** Releases the tag.
          */
-        static inline sTag create(string&& name) noexcept
+        inline ~TagPtr() noexcept
+        {
+            if(m_tag)
+            {
+                m_tag->release();
+            }
+        }
+        
+        inline TagPtr& operator=(TagPtr const& other) noexcept
         {
-            lock_guard<mutex> guard(m_mutex);
-            auto it = m_tags.find(name);
-            if(it != m_tags.end())
+            if(other.m_tag)
             {
-                return it->second;
+                other.m_tag->retain();
             }
-            else
+            if(m_tag)
             {
-                sTag tag = make_shared<Tag>(name);
-                m_tags[name] = tag;
-                return tag;
+                m_tag->release();
             }
+            m_tag = other.m_tag;
+            return *this;
         }
         
-        class List;
+        inline TagPtr& operator=(TagPtr&& other) noexcept
+        {
+            std::swap(m_tag, other.m_tag);
+            return *this;
+        }
+        
+        //! Retrieves a shared pointer to the tag.
+        /** The shared pointer retains the tag until it is released.
+         */
+        inline operator shared_ptr<const Tag>() const noexcept
+        {
+            if(m_tag)
+            {
+                m_tag->retain();
+                return shared_ptr<const Tag>(m_tag, [](const Tag* tag) {tag->release();});
+            }
+            return shared_ptr<const Tag>();
+        }
+        
+        inline const Tag* get() const noexcept {return m_tag;}
+        inline const Tag* operator->() const noexcept {return m_tag;}
+        inline const Tag& operator*() const noexcept {return *m_tag;}
+        inline explicit operator bool() const noexcept {return m_tag != nullptr;}
+        inline void reset() noexcept {TagPtr().swap(*this);}
+        inline void swap(TagPtr& other) noexcept {std::swap(m_tag, other.m_tag);}
+        
+        inline bool operator==(TagPtr const& other) const noexcept {return m_tag == other.m_tag;}
+        inline bool operator!=(TagPtr const& other) const noexcept {return m_tag != other.m_tag;}
+        inline bool operator<(TagPtr const& other) const noexcept {return m_tag < other.m_tag;}
+        inline bool operator==(nullptr_t) const noexcept {return m_tag == nullptr;}
+        inline bool operator!=(nullptr_t) const noexcept {return m_tag != nullptr;}
     };
     
+    inline sTag Tag::create(char const* name) noexcept
+    {
+        return create(string_view(name));
+    }
+    
+    //! Retrieve the tag of a string literal.
+    /** The macro hashes the string literal at compile time and creates the tag the first time the expression is evaluated, the next evaluations only return the same tag without any lookup. Unlike the Tags constants, it can be used during the static initialization.
+     @code
+     if(name == KIWI_TAG("bang"))
+     @endcode
+     */
+    #define KIWI_TAG(literal) ([]() noexcept -> Kiwi::sTag const& {\
+        static constexpr Kiwi::Tag::Literal _literal(literal);\
+        static const Kiwi::sTag _tag = Kiwi::Tag::create(_literal);\
+        return _tag;}())
+    
+    //! The tags used by kiwi.
+    /** The constants are created during the static initialization of the library, use KIWI_TAG if you need a tag in another static initialization.
+     @see KIWI_TAG
+     */
     class Tags
     {
     public:
@@ -203,6 +569,17 @@ namespace Kiwi
 };
 
 
+namespace std
+{
+    template<> struct hash<Kiwi::TagPtr>
+    {
+        inline size_t operator()(Kiwi::TagPtr const& tag) const noexcept
+        {
+            return hash<const Kiwi::Tag*>()(tag.get());
+        }
+    };
+}
+
 #endif
 
 
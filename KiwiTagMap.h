@@ -0,0 +1,265 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+#ifndef __DEF_KIWI_TAGMAP__
+#define __DEF_KIWI_TAGMAP__
+
+#include "KiwiTag.h"
+
+namespace Kiwi
+{
+    // ================================================================================ //
+    //                                      TAG MAP                                     //
+    // ================================================================================ //
+    
+    //! The tag map is an associative container indexed by the ids of the tags.
+    /** The tag map is a sparse set : a paged array indexed by the id of the tag retrieves the position of the value in a dense array. The lookup is an array indexing and the iteration walks through a contiguous array. The order of the iteration is the order of insertion, except after an erasure that moves the last value at the position of the erased one. The table of the pages grows with the largest id, so when the ids are too sparse for the number of values the positions are moved to a hash index and the memory of the map only depends on its size.
+     @see Tag::getId
+     */
+    template <class T> class TagMap
+    {
+    public:
+        typedef pair<sTag, T>                           value_type;
+        typedef typename vector<value_type>::size_type  size_type;
+        typedef typename vector<value_type>::iterator   iterator;
+        typedef typename vector<value_type>::const_iterator const_iterator;
+        
+    private:
+        static const ulong page_size = 32ul;
+        static const ulong page_table_size = 64ul;
+        typedef array<unsigned, page_size> Page;
+        
+        vector<value_type>              m_values;
+        vector<unique_ptr<Page>>        m_pages;
+        unordered_map<ulong, unsigned>  m_sparse;
+        
+        //! Retrieves the position of a tag in the dense array plus one, zero if the tag isn't in the map.
+        inline unsigned index(const sTag& tag) const noexcept
+        {
+            if(!m_sparse.empty())
+            {
+                auto it = m_sparse.find(tag->getId());
+                return it != m_sparse.end() ? it->second : 0u;
+            }
+            const ulong page = tag->getId() / page_size;
+            if(page < m_pages.size() && m_pages[page])
+            {
+                return (*m_pages[page])[tag->getId() % page_size];
+            }
+            return 0u;
+        }
+        
+        //! Retrieves the slot of a tag in the paged array or in the hash index, the slot is created if needed.
+        unsigned& slot(const sTag& tag)
+        {
+            if(m_sparse.empty())
+            {
+                const ulong page = tag->getId() / page_size;
+                if(page < m_pages.size() || page < page_table_size || page < m_values.size() * 2ul)
+                {
+                    if(page >= m_pages.size())
+                    {
+                        m_pages.resize(page + 1ul);
+                    }
+                    if(!m_pages[page])
+                    {
+                        m_pages[page] = unique_ptr<Page>(new Page());
+                        m_pages[page]->fill(0u);
+                    }
+                    return (*m_pages[page])[tag->getId() % page_size];
+                }
+                
+                // The table of the pages would be too large for the number of values
+                for(size_type i = 0; i < m_values.size(); i++)
+                {
+                    m_sparse.emplace(m_values[i].first->getId(), unsigned(i + 1u));
+                }
+                m_pages.clear();
+            }
+            return m_sparse[tag->getId()];
+        }
+        
+    public:
+        
+        //! Constructor.
+        /** Creates an empty tag map.
+         */
+        inline TagMap() noexcept {}
+        
+        //! Constructor.
+        /** Creates a tag map with a list of values.
+         */
+        inline TagMap(initializer_list<value_type> il)
+        {
+            for(auto const& it : il)
+            {
+                (*this)[it.first] = it.second;
+            }
+        }
+        
+        //! Constructor.
+        /** Creates a copy of another tag map.
+         */
+        TagMap(TagMap const& other) : m_values(other.m_values), m_sparse(other.m_sparse)
+        {
+            m_pages.resize(other.m_pages.size());
+            for(size_type i = 0; i < m_pages.size(); i++)
+            {
+                if(other.m_pages[i])
+                {
+                    m_pages[i] = unique_ptr<Page>(new Page(*other.m_pages[i]));
+                }
+            }
+        }
+        
+        //! Constructor.
+        /** Creates a tag map with the values of another one.
+         */
+        inline TagMap(TagMap&& other) noexcept = default;
+        
+        //! Destructor.
+        /** Frees the values.
+         */
+        inline ~TagMap() noexcept {}
+        
+        //! Replaces the values with the values of another tag map.
+        inline TagMap& operator=(TagMap const& other)
+        {
+            if(&other != this)
+            {
+                TagMap copy(other);
+                swap(copy);
+            }
+            return *this;
+        }
+        
+        //! Replaces the values with the values of another tag map.
+        inline TagMap& operator=(TagMap&& other) noexcept = default;
+        
+        //! Swaps the values with another tag map.
+        inline void swap(TagMap& other) noexcept
+        {
+            m_values.swap(other.m_values);
+            m_pages.swap(other.m_pages);
+            m_sparse.swap(other.m_sparse);
+        }
+        
+        inline iterator begin() noexcept {return m_values.begin();}
+        inline iterator end() noexcept {return m_values.end();}
+        inline const_iterator begin() const noexcept {return m_values.begin();}
+        inline const_iterator end() const noexcept {return m_values.end();}
+        inline size_type size() const noexcept {return m_values.size();}
+        inline bool empty() const noexcept {return m_values.empty();}
+        
+        //! Retrieves a value.
+        /** The function retrieves the value of a tag.
+         @param tag The tag.
+         @return An iterator to the value or the end if the tag isn't in the map.
+         */
+        inline iterator find(const sTag& tag) noexcept
+        {
+            const unsigned i = index(tag);
+            return i ? m_values.begin() + (i - 1u) : m_values.end();
+        }
+        
+        //! Retrieves a value.
+        /** The function retrieves the value of a tag.
+         @param tag The tag.
+         @return An iterator to the value or the end if the tag isn't in the map.
+         */
+        inline const_iterator find(const sTag& tag) const noexcept
+        {
+            const unsigned i = index(tag);
+            return i ? m_values.begin() + (i - 1u) : m_values.end();
+        }
+        
+        //! Checks if a tag is in the map.
+        /** The function checks if a tag is in the map.
+         @param tag The tag.
+         @return 1 if the tag is in the map, otherwise 0.
+         */
+        inline size_type count(const sTag& tag) const noexcept
+        {
+            return index(tag) ? 1 : 0;
+        }
+        
+        //! Retrieves or creates a value.
+        /** The function retrieves the value of a tag, if the tag isn't in the map a default value is inserted.
+         @param tag The tag.
+         @return The value.
+         */
+        inline T& operator[](const sTag& tag)
+        {
+            unsigned& i = slot(tag);
+            if(!i)
+            {
+                m_values.emplace_back(tag, T());
+                i = unsigned(m_values.size());
+            }
+            return m_values[i - 1u].second;
+        }
+        
+        //! Removes a value.
+        /** The function removes the value of a tag, the last value is moved to its position.
+         @param tag The tag.
+         @return 1 if the tag was in the map, otherwise 0.
+         */
+        size_type erase(const sTag& tag)
+        {
+            const unsigned i = index(tag);
+            if(i)
+            {
+                if(m_sparse.empty())
+                {
+                    slot(tag) = 0u;
+                }
+                else
+                {
+                    m_sparse.erase(tag->getId());
+                }
+                if(i != m_values.size())
+                {
+                    m_values[i - 1u] = move(m_values.back());
+                    slot(m_values[i - 1u].first) = i;
+                }
+                m_values.pop_back();
+                return 1;
+            }
+            return 0;
+        }
+        
+        //! Removes all the values.
+        /** The function removes all the values.
+         */
+        inline void clear() noexcept
+        {
+            m_values.clear();
+            m_pages.clear();
+            m_sparse.clear();
+        }
+    };
+}
+
+#endif
+
+
@@ -32,16 +32,25 @@
 #include <iomanip>
 #include <fstream>
 #include <cstring>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <charconv>
 #include <algorithm>
 #include <memory>
 #include <cmath>
 #include <array>
+#include <bitset>
 #include <vector>
 #include <map>
 #include <list>
 #include <set>
+#include <unordered_set>
+#include <unordered_map>
 #include <deque>
 #include <thread>
+#include <mutex>
+#include <atomic>
 #include <typeinfo>
 #include <typeindex>
 #include <codecvt>
@@ -75,8 +84,8 @@ namespace Kiwi
     class Atom;
     
     class Tag;
-    typedef shared_ptr<const Tag>       sTag;
-    typedef weak_ptr<const Tag>         wTag;
+    class TagPtr;
+    typedef TagPtr                      sTag;
     
     class Clock;
     typedef shared_ptr<Clock>           sClock;
@@ -87,9 +96,14 @@ namespace Kiwi
     typedef weak_ptr<Beacon>            wBeacon;
 
     typedef unsigned long               ulong;
-    typedef shared_ptr<const Tag>       sTag;
-    typedef vector<Atom>                Vector;
-    typedef map<sTag, Atom>             Dico;
+    template <class T, ulong N> class SmallVector;
+    typedef SmallVector<Atom, 4ul>      Vector;
+    typedef vector<double>              Doubles;
+    typedef vector<float>               Floats;
+    template <class T> class FlatMap;
+    typedef FlatMap<Atom>               Dico;
+    template <class T> class PersistentMap;
+    typedef PersistentMap<Atom>         PersistentDico;
     
     class Error : public exception
     {
@@ -379,58 +393,138 @@ namespace Kiwi
     
     static inline string jsonEscape(string const& text)
     {
-        ostringstream ss;
+        string result;
+        result.reserve(text.size() + 2);
+        result += '\"';
         for(auto iter = text.cbegin(); iter != text.cend(); iter++)
         {
             switch (*iter)
             {
-                case '\\': ss << "\\\\"; break;
-                case '"': ss << "\\\""; break;
-                case '/': ss << "\\/"; break;
-                case '\b': ss << "\\b"; break;
-                case '\f': ss << "\\f"; break;
-                case '\n': ss << "\\n"; break;
-                case '\r': ss << "\\r"; break;
-                case '\t': ss << "\\t"; break;
-                default: ss << *iter; break;
+                case '\\': result += "\\\\"; break;
+                case '"': result += "\\\""; break;
+                case '/': result += "\\/"; break;
+                case '\b': result += "\\b"; break;
+                case '\f': result += "\\f"; break;
+                case '\n': result += "\\n"; break;
+                case '\r': result += "\\r"; break;
+                case '\t': result += "\\t"; break;
+                default:
+                    if((unsigned char)*iter < 0x20)
+                    {
+                        const char hex[] = "0123456789abcdef";
+                        result += "\\u00";
+                        result += hex[(unsigned char)*iter >> 4];
+                        result += hex[*iter & 0xf];
+                    }
+                    else
+                    {
+                        result += *iter;
+                    }
+                    break;
             }
         }
-        return '\"' + ss.str() + '\"';
+        result += '\"';
+        return result;
+    }
+    
+    //! Appends a code point encoded in UTF-8 to a string.
+    static inline void appendUtf8(string& text, const ulong code)
+    {
+        if(code < 0x80)
+        {
+            text += char(code);
+        }
+        else if(code < 0x800)
+        {
+            text += char(0xC0 | (code >> 6));
+            text += char(0x80 | (code & 0x3F));
+        }
+        else if(code < 0x10000)
+        {
+            text += char(0xE0 | (code >> 12));
+            text += char(0x80 | ((code >> 6) & 0x3F));
+            text += char(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            text += char(0xF0 | (code >> 18));
+            text += char(0x80 | ((code >> 12) & 0x3F));
+            text += char(0x80 | ((code >> 6) & 0x3F));
+            text += char(0x80 | (code & 0x3F));
+        }
     }
     
     static inline string jsonUnescape(string const& text)
     {
-        bool state = false;
-        ostringstream ss;
-        for(auto iter = text.cbegin(); iter != text.cend(); iter++)
+        // Reads the four hexadecimal digits of a unicode escape, -1 if they aren't valid
+        auto hex = [&text](const string::size_type pos) -> long
         {
-            if(state)
+            long code = 0;
+            for(string::size_type i = pos; i < pos + 4; i++)
             {
-                switch(*iter)
+                if(i >= text.size() || !isxdigit((unsigned char)text[i]))
                 {
-                    case '"': ss << '\"'; break;
-                    case '/': ss << '/'; break;
-                    case 'b': ss << '\b'; break;
-                    case 'f': ss << '\f'; break;
-                    case 'n': ss << '\n'; break;
-                    case 'r': ss << '\r'; break;
-                    case 't': ss << '\t'; break;
-                    case '\\': ss << '\\'; break;
-                    default: ss << *iter; break;
+                    return -1;
                 }
-                state = false;
+                code = code * 16 + (isdigit((unsigned char)text[i]) ? text[i] - '0' : (tolower((unsigned char)text[i]) - 'a' + 10));
+            }
+            return code;
+        };
+        
+        string result;
+        result.reserve(text.size());
+        for(string::size_type i = 0; i < text.size(); i++)
+        {
+            if(text[i] == '"')
+            {
+                return result;
+            }
+            else if(text[i] != '\\')
+            {
+                result += text[i];
+                continue;
+            }
+            else if(++i == text.size())
+            {
+                break;
             }
-            else
+            switch(text[i])
             {
-                switch(*iter)
+                case '"': result += '\"'; break;
+                case '/': result += '/'; break;
+                case 'b': result += '\b'; break;
+                case 'f': result += '\f'; break;
+                case 'n': result += '\n'; break;
+                case 'r': result += '\r'; break;
+                case 't': result += '\t'; break;
+                case '\\': result += '\\'; break;
+                case 'u':
                 {
-                    case '"': return ss.str();
-                    case '\\': state = true; break;
-                    default: ss << *iter; break;
+                    long code = hex(i + 1);
+                    if(code < 0)
+                    {
+                        result += 'u';
+                        break;
+                    }
+                    i += 4;
+                    
+                    // A high surrogate is combined with the low surrogate that follows it
+                    if(code >= 0xD800 && code < 0xDC00 && i + 2 < text.size() && text[i + 1] == '\\' && text[i + 2] == 'u')
+                    {
+                        const long low = hex(i + 3);
+                        if(low >= 0xDC00 && low < 0xE000)
+                        {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            i += 6;
+                        }
+                    }
+                    appendUtf8(result, ulong(code));
+                    break;
                 }
+                default: result += text[i]; break;
             }
         }
-        return ss.str();
+        return result;
     }
     
 };
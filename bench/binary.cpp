@@ -0,0 +1,107 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+// Measures the opening of a bank of presets by its path and the access to a few of its values.
+// g++ -std=c++17 -O2 -pthread -I.. binary.cpp ../*.cpp -o binary && ./binary
+
+#include "../KiwiCore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace Kiwi;
+
+//! Runs a function once and returns its duration in microseconds.
+template <class F> static double duration(F&& function)
+{
+    const auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+//! Creates a bank of presets whose parameters have distinct names.
+static Atom generate(const ulong count)
+{
+    Dico bank;
+    for(ulong i = 0; i < count; i++)
+    {
+        Dico preset;
+        preset[Tag::create("gain" + to_string(i))] = Atom(double(i) * 0.5);
+        preset[Tag::create("name")] = Atom(Tag::create("preset" + to_string(i)));
+        preset[Tag::create("position")] = Atom({Atom(double(i % 640ul)), Atom(double(i % 480ul))});
+        bank[Tag::create("preset" + to_string(i))] = Atom(move(preset));
+    }
+    return Atom(move(bank));
+}
+
+int main()
+{
+    const char* path = "bank.kiwi";
+    const Atom bank = generate(100000ul);
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0 || !Binary::write(fd, bank))
+    {
+        cout << "the bank can't be written" << endl;
+        return 1;
+    }
+    ::close(fd);
+    
+    double gain = 0.;
+    size_t size = 0ul;
+    bool valid = false;
+    const double opening = duration([&]()
+    {
+        Binary::File file(path);
+        valid = file.isValid();
+        size = file.getSize();
+    });
+    
+    Binary::File file(path);
+    const double lookup = duration([&]()
+    {
+        Binary::View preset = file.getRoot()[Tag::create("preset99999")];
+        gain = double(preset[Tag::create("gain99999")]);
+    });
+    
+    Atom atom;
+    const double decoding = duration([&]()
+    {
+        atom = file.getRoot().toAtom();
+    });
+    remove(path);
+    
+    if(!valid || gain != 49999.5 || atom != bank)
+    {
+        cout << "the bank isn't read back" << endl;
+        return 1;
+    }
+    
+    cout << size / 1024ul << " KB" << endl << endl;
+    cout << fixed << setprecision(1);
+    cout << setw(40) << left << "Binary::File by path" << right << setw(12) << opening << " us" << endl;
+    cout << setw(40) << left << "Binary::View lookup of one value" << right << setw(12) << lookup << " us" << endl;
+    cout << setw(40) << left << "Binary::View::toAtom" << right << setw(12) << decoding << " us" << endl;
+    return 0;
+}
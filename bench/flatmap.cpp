@@ -0,0 +1,206 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+// Compares the flat map of the dicos with the standard maps.
+// g++ -std=c++17 -O2 -pthread -I.. flatmap.cpp ../*.cpp -o flatmap && ./flatmap
+
+#include "../KiwiCore.h"
+
+#include <chrono>
+#include <random>
+#include <unordered_map>
+
+using namespace Kiwi;
+
+//! Runs a function a number of times and returns the time of one run in nanoseconds.
+template <class F> static double measure(const ulong runs, F&& function)
+{
+    const auto start = chrono::steady_clock::now();
+    for(ulong i = 0; i < runs; i++)
+    {
+        function();
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / double(runs);
+}
+
+//! Checks the flat map against a standard map with random insertions, replacements, lookups and erasures.
+static bool check(vector<sTag> const& tags, const ulong steps, const ulong seed)
+{
+    mt19937 random{uint32_t(seed)};
+    FlatMap<long> map;
+    std::map<sTag, long> reference;
+    for(ulong step = 0; step < steps; step++)
+    {
+        const sTag& tag = tags[random() % tags.size()];
+        const long value = long(random());
+        switch(random() % 6)
+        {
+            case 0:
+            {
+                if(map.emplace(tag, value).second != reference.emplace(tag, value).second)
+                {
+                    return false;
+                }
+                break;
+            }
+            case 1:
+            {
+                map.insert_or_assign(tag, value);
+                reference[tag] = value;
+                break;
+            }
+            case 2:
+            {
+                if(map.erase(tag) != reference.erase(tag))
+                {
+                    return false;
+                }
+                break;
+            }
+            case 3:
+            {
+                auto it = map.find(tag);
+                if(it != map.end())
+                {
+                    reference.erase(it->first);
+                    map.erase(it);
+                }
+                break;
+            }
+            case 4:
+            {
+                map[tag] += value;
+                reference[tag] += value;
+                break;
+            }
+            default:
+            {
+                FlatMap<long> copy(map);
+                if(copy != map)
+                {
+                    return false;
+                }
+                map = move(copy);
+                break;
+            }
+        }
+        
+        if(map.size() != reference.size())
+        {
+            return false;
+        }
+        for(auto const& entry : map)
+        {
+            auto it = reference.find(entry.first);
+            if(it == reference.end() || it->second != entry.second)
+            {
+                return false;
+            }
+        }
+        for(auto const& entry : reference)
+        {
+            if(!map.count(entry.first) || map.find(entry.first)->second != entry.second)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//! Measures the insertion, the lookup and the iteration of a map type.
+template <class Map> static void bench(char const* name, vector<sTag> const& tags, const ulong runs)
+{
+    volatile long sink = 0;
+    const double insert = measure(runs, [&]()
+    {
+        Map map;
+        for(ulong i = 0; i < tags.size(); i++)
+        {
+            map[tags[i]] = long(i);
+        }
+        sink = sink + long(map.size());
+    });
+    
+    Map map;
+    for(ulong i = 0; i < tags.size(); i++)
+    {
+        map[tags[i]] = long(i);
+    }
+    const double find = measure(runs, [&]()
+    {
+        long sum = 0;
+        for(auto const& tag : tags)
+        {
+            sum += map.find(tag)->second;
+        }
+        sink = sink + sum;
+    });
+    const double iterate = measure(runs, [&]()
+    {
+        long sum = 0;
+        for(auto const& entry : map)
+        {
+            sum += entry.second;
+        }
+        sink = sink + sum;
+    });
+    
+    const double count = double(tags.size());
+    cout << setw(16) << name << setw(8) << tags.size() << fixed << setprecision(2)
+         << setw(12) << insert / count << setw(12) << find / count << setw(12) << iterate / count << endl;
+}
+
+int main()
+{
+    vector<sTag> tags;
+    for(ulong i = 0; i < 4096; i++)
+    {
+        tags.push_back(Tag::create("flatmap" + to_string(i)));
+    }
+    
+    // The small maps are searched linearly and the large ones through the index
+    const ulong sizes[] = {4ul, 8ul, 12ul, 64ul, 1024ul};
+    for(ulong i = 0; i < sizeof(sizes) / sizeof(ulong); i++)
+    {
+        const vector<sTag> subset(tags.begin(), tags.begin() + long(sizes[i]));
+        if(!check(subset, 20000ul, sizes[i]))
+        {
+            cout << "the flat map differs from the standard map with " << sizes[i] << " tags" << endl;
+            return 1;
+        }
+    }
+    cout << "the flat map matches the standard map" << endl << endl;
+    
+    cout << setw(16) << "map" << setw(8) << "size" << setw(12) << "insert ns" << setw(12) << "find ns" << setw(12) << "iterate ns" << endl;
+    for(ulong i = 0; i < sizeof(sizes) / sizeof(ulong); i++)
+    {
+        vector<sTag> subset(tags.begin(), tags.begin() + long(sizes[i]));
+        shuffle(subset.begin(), subset.end(), mt19937(7u));
+        const ulong runs = max(1ul, 400000ul / sizes[i]);
+        bench<FlatMap<long>>("FlatMap", subset, runs);
+        bench<std::map<sTag, long>>("std::map", subset, runs);
+        bench<std::unordered_map<sTag, long>>("unordered_map", subset, runs);
+    }
+    return 0;
+}
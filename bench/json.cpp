@@ -0,0 +1,128 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+// Measures the throughput of the reading and the writing of the json.
+// g++ -std=c++17 -O2 -pthread -I.. json.cpp ../*.cpp -o json && ./json
+
+#include "../KiwiCore.h"
+
+#include <chrono>
+#include <random>
+
+using namespace Kiwi;
+
+//! Runs a function a number of times and returns the throughput in megabytes per second.
+template <class F> static double throughput(const size_t size, const ulong runs, F&& function)
+{
+    const auto start = chrono::steady_clock::now();
+    for(ulong i = 0; i < runs; i++)
+    {
+        function();
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return double(size) * double(runs) / seconds / 1048576.;
+}
+
+//! Counts the values of a json text without building the atoms.
+class Counter
+{
+public:
+    ulong values = 0ul;
+    
+    inline void value(Atom&&) noexcept {values++;}
+    inline void key(sTag const&) noexcept {}
+    inline void beginVector() noexcept {}
+    inline void endVector() noexcept {values++;}
+    inline void beginDico() noexcept {}
+    inline void endDico() noexcept {values++;}
+};
+
+//! Creates a patch of objects with their attributes, their arguments and their positions.
+static Atom generate(const ulong count)
+{
+    mt19937 random{42u};
+    Vector objects;
+    for(ulong i = 0; i < count; i++)
+    {
+        Vector arguments;
+        for(ulong j = random() % 4ul; j; j--)
+        {
+            arguments.push_back(random() % 2u ? Atom(long(random() % 1000u)) : Atom(double(random() % 100000u) / 100.));
+        }
+        objects.push_back(Atom(Dico{
+            {Tag::create("name"), Atom(Tag::create("object" + to_string(random() % 32u)))},
+            {Tag::create("id"), Atom(long(i))},
+            {Tag::create("text"), Atom(Tag::create("a \"quoted\" text " + to_string(random() % 8u)))},
+            {Tag::create("position"), Atom({Atom(double(random() % 1000u) / 2.), Atom(double(random() % 1000u) / 2.)})},
+            {Tag::create("arguments"), Atom(move(arguments))},
+            {Tag::create("hidden"), Atom(bool(random() % 2u))}
+        }));
+    }
+    return Atom(Dico{{Tag::create("objects"), Atom(move(objects))}});
+}
+
+int main()
+{
+    const Atom patch = generate(50000ul);
+    const string text = Json::write(patch);
+    const string pretty = Json::write(patch, true);
+    cout << text.size() / 1024ul << " KB compact, " << pretty.size() / 1024ul << " KB pretty" << endl << endl;
+    
+    volatile ulong sink = 0ul;
+    const double building = throughput(text.size(), 10ul, [&]()
+    {
+        Atom atom;
+        sink = sink + Json::read(text, atom);
+    });
+    
+    const double scanning = throughput(text.size(), 10ul, [&]()
+    {
+        Counter counter;
+        Json::Reader reader(text);
+        sink = sink + reader.parse(counter) + counter.values;
+    });
+    
+    const double compact = throughput(text.size(), 10ul, [&]()
+    {
+        sink = sink + Json::write(patch).size();
+    });
+    
+    const double indented = throughput(pretty.size(), 10ul, [&]()
+    {
+        sink = sink + Json::write(patch, true).size();
+    });
+    
+    Atom atom;
+    if(!Json::read(text, atom) || Json::write(atom) != text)
+    {
+        cout << "the json doesn't round trip" << endl;
+        return 1;
+    }
+    
+    cout << fixed << setprecision(1);
+    cout << setw(40) << left << "Json::read" << right << setw(10) << building << " MB/s" << endl;
+    cout << setw(40) << left << "Json::Reader without atoms" << right << setw(10) << scanning << " MB/s" << endl;
+    cout << setw(40) << left << "Json::write" << right << setw(10) << compact << " MB/s" << endl;
+    cout << setw(40) << left << "Json::write pretty" << right << setw(10) << indented << " MB/s" << endl;
+    return 0;
+}
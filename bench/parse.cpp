@@ -0,0 +1,120 @@
+/*
+ ==============================================================================
+ 
+ This file is part of the KIWI library.
+ Copyright (c) 2014 Pierre Guillot & Eliott Paris.
+ 
+ Permission is granted to use this software under the terms of either:
+ a) the GPL v2 (or any later version)
+ b) the Affero GPL v3
+ 
+ Details of these licenses can be found at: www.gnu.org/licenses
+ 
+ KIWI is distributed in the hope that it will be useful, but WITHOUT ANY
+ WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ 
+ ------------------------------------------------------------------------------
+ 
+ To release a closed-source product which uses KIWI, contact : guillotpierre6@gmail.com
+ 
+ ==============================================================================
+*/
+
+// Measures the throughput of the parsing of the messages.
+// g++ -std=c++17 -O2 -pthread -I.. parse.cpp ../*.cpp -o parse && ./parse
+
+#include "../KiwiCore.h"
+
+#include <chrono>
+#include <random>
+
+using namespace Kiwi;
+
+//! Runs a function a number of times and returns the throughput in megabytes per second.
+template <class F> static double throughput(const size_t size, const ulong runs, F&& function)
+{
+    const auto start = chrono::steady_clock::now();
+    for(ulong i = 0; i < runs; i++)
+    {
+        function();
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return double(size) * double(runs) / seconds / 1048576.;
+}
+
+//! Creates messages made of words, integers, decimals and quoted words, a quarter of the quoted words have escapes.
+static vector<string> generate(const ulong count)
+{
+    mt19937 random{42u};
+    vector<string> result;
+    for(ulong i = 0; i < count; i++)
+    {
+        string message;
+        const ulong size = 1ul + random() % 12ul;
+        for(ulong j = 0; j < size; j++)
+        {
+            switch(random() % 4)
+            {
+                case 0:  message += "word" + to_string(random() % 64u); break;
+                case 1:  message += to_string(long(random() % 100000u) - 50000l); break;
+                case 2:  message += to_string(double(random() % 100000u) / 1000.); break;
+                default: message += random() % 4u ? "\"quoted word " + to_string(random() % 16u) + "\"" : "\"quoted \\\"word\\\"\""; break;
+            }
+            message += ' ';
+        }
+        result.push_back(move(message));
+    }
+    return result;
+}
+
+int main()
+{
+    const vector<string> texts = generate(100000ul);
+    size_t size = 0ul, natoms = 0ul;
+    string stream;
+    for(auto const& text : texts)
+    {
+        size += text.size();
+        natoms += Atom::parse(text).size();
+        stream += text;
+        stream += ";\n";
+    }
+    cout << texts.size() << " messages, " << natoms << " atoms, " << size / 1024ul << " KB" << endl << endl;
+    
+    volatile ulong sink = 0ul;
+    const double allocating = throughput(size, 10ul, [&]()
+    {
+        for(auto const& text : texts)
+        {
+            sink = sink + Atom::parse(text).size();
+        }
+    });
+    
+    Vector atoms;
+    const double reusing = throughput(size, 10ul, [&]()
+    {
+        for(auto const& text : texts)
+        {
+            Atom::parse(text, atoms);
+            sink = sink + atoms.size();
+        }
+    });
+    
+    const double streaming = throughput(stream.size(), 10ul, [&]()
+    {
+        Atom::Tokenizer tokenizer;
+        auto callback = [&](Vector const& message) {sink = sink + message.size();};
+        for(size_t pos = 0ul; pos < stream.size(); pos += 4096ul)
+        {
+            tokenizer.write(string_view(stream).substr(pos, 4096ul), callback);
+        }
+        tokenizer.flush(callback);
+    });
+    
+    cout << fixed << setprecision(1);
+    cout << setw(40) << left << "Atom::parse" << right << setw(10) << allocating << " MB/s" << endl;
+    cout << setw(40) << left << "Atom::parse with a reused vector" << right << setw(10) << reusing << " MB/s" << endl;
+    cout << setw(40) << left << "Atom::Tokenizer with 4 KB chunks" << right << setw(10) << streaming << " MB/s" << endl;
+    return 0;
+}